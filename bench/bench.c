@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#  include <psapi.h>
+#else
+#  include <sys/resource.h>
+#endif
+
+#include "../resect.h"
+#include "bench.h"
+
+#define MAX_INCLUDE_PATHS 64
+
+static const char *phase_names[] = {"clang", "shaking", "registry", "parse", "teardown"};
+
+static const char *counter_names[] = {
+    "cursors", "graph nodes", "graph edges", "types", "registry hits", "registry misses", "pattern matches",
+    "bytes allocated"
+};
+
+#define PHASE_COUNT (sizeof(phase_names) / sizeof(phase_names[0]))
+#define COUNTER_COUNT (sizeof(counter_names) / sizeof(counter_names[0]))
+
+typedef struct {
+    int iterations;
+    int parallel;
+    const char *language;
+    const char *resource_path;
+    const char *include_paths[MAX_INCLUDE_PATHS];
+    int include_path_count;
+} bench_run_options;
+
+static void print_usage() {
+    fprintf(stderr,
+            "Usage:\n"
+            "  resect-bench generate [--decls N] [--template-depth N] [--overloads N] [--namespace-depth N]"
+            " [--output FILE]\n"
+            "  resect-bench run [--iterations N] [--parallel N] [--language LANG] [--resource-dir DIR] [--include DIR]..."
+            " HEADER...\n");
+}
+
+static long long peak_rss_kb() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return -1;
+    }
+    return (long long) counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#  if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#  else
+    return usage.ru_maxrss;
+#  endif
+#endif
+}
+
+static int parse_int_argument(int argc, char **argv, int *i) {
+    if (*i + 1 >= argc) {
+        fprintf(stderr, "Missing value for %s\n", argv[*i]);
+        exit(1);
+    }
+    return atoi(argv[++*i]);
+}
+
+static const char *parse_string_argument(int argc, char **argv, int *i) {
+    if (*i + 1 >= argc) {
+        fprintf(stderr, "Missing value for %s\n", argv[*i]);
+        exit(1);
+    }
+    return argv[++*i];
+}
+
+static int generate(int argc, char **argv) {
+    resect_bench_generator_options options = {
+        .decl_count = 100,
+        .template_depth = 4,
+        .overload_count = 2,
+        .namespace_depth = 2,
+    };
+    const char *output = NULL;
+
+    for (int i = 0; i < argc; ++i) {
+        if (strcmp(argv[i], "--decls") == 0) {
+            options.decl_count = parse_int_argument(argc, argv, &i);
+        } else if (strcmp(argv[i], "--template-depth") == 0) {
+            options.template_depth = parse_int_argument(argc, argv, &i);
+        } else if (strcmp(argv[i], "--overloads") == 0) {
+            options.overload_count = parse_int_argument(argc, argv, &i);
+        } else if (strcmp(argv[i], "--namespace-depth") == 0) {
+            options.namespace_depth = parse_int_argument(argc, argv, &i);
+        } else if (strcmp(argv[i], "--output") == 0) {
+            output = parse_string_argument(argc, argv, &i);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    FILE *out = output != NULL ? fopen(output, "w") : stdout;
+    if (out == NULL) {
+        fprintf(stderr, "Failed to open %s\n", output);
+        return 1;
+    }
+
+    resect_bench_generate(out, &options);
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
+
+static resect_parse_options create_parse_options(const bench_run_options *run_options) {
+    resect_parse_options options = resect_options_create();
+    resect_options_include_source(options, ".*");
+    resect_options_add_language(options, run_options->language);
+    if (run_options->parallel > 1) {
+        resect_options_parallel(options, run_options->parallel);
+    }
+    if (run_options->resource_path != NULL) {
+        resect_options_add_resource_path(options, run_options->resource_path);
+    }
+    for (int i = 0; i < run_options->include_path_count; ++i) {
+        resect_options_add_include_path(options, run_options->include_paths[i]);
+    }
+    return options;
+}
+
+static void bench_header(const char *filename, const bench_run_options *run_options) {
+    double wall_time[PHASE_COUNT] = {0};
+    double cpu_time[PHASE_COUNT] = {0};
+    unsigned long long counters[COUNTER_COUNT] = {0};
+    unsigned int decl_count = 0;
+
+    for (int iteration = 0; iteration < run_options->iterations; ++iteration) {
+        resect_parse_options options = create_parse_options(run_options);
+        resect_translation_unit unit = resect_parse(filename, options);
+        resect_options_free(options);
+
+        decl_count = resect_collection_size(resect_unit_declarations(unit));
+        for (unsigned int phase = 0; phase < PHASE_COUNT; ++phase) {
+            wall_time[phase] += resect_unit_phase_wall_time(unit, (resect_phase) phase);
+            cpu_time[phase] += resect_unit_phase_cpu_time(unit, (resect_phase) phase);
+        }
+        for (unsigned int counter = 0; counter < COUNTER_COUNT; ++counter) {
+            counters[counter] = resect_unit_counter(unit, (resect_counter) counter);
+        }
+
+        resect_free(unit);
+    }
+
+    double total_wall_time = 0;
+    for (unsigned int phase = 0; phase < PHASE_COUNT; ++phase) {
+        wall_time[phase] /= run_options->iterations;
+        cpu_time[phase] /= run_options->iterations;
+        total_wall_time += wall_time[phase];
+    }
+
+    printf("%s\n", filename);
+    printf("  decls: %u, wall: %.3f ms, throughput: %.0f decls/s\n",
+           decl_count, total_wall_time * 1000,
+           total_wall_time > 0 ? decl_count / total_wall_time : 0);
+    for (unsigned int phase = 0; phase < PHASE_COUNT; ++phase) {
+        printf("  %-10s wall: %10.3f ms  cpu: %10.3f ms\n",
+               phase_names[phase], wall_time[phase] * 1000, cpu_time[phase] * 1000);
+    }
+    for (unsigned int counter = 0; counter < COUNTER_COUNT; ++counter) {
+        printf("  %-16s %llu\n", counter_names[counter], counters[counter]);
+    }
+}
+
+static int run(int argc, char **argv) {
+    bench_run_options options = {
+        .iterations = 1,
+        .parallel = 0,
+        .language = "c++",
+        .resource_path = NULL,
+        .include_path_count = 0,
+    };
+
+    int i = 0;
+    for (; i < argc && strncmp(argv[i], "--", 2) == 0; ++i) {
+        if (strcmp(argv[i], "--iterations") == 0) {
+            options.iterations = parse_int_argument(argc, argv, &i);
+        } else if (strcmp(argv[i], "--parallel") == 0) {
+            options.parallel = parse_int_argument(argc, argv, &i);
+        } else if (strcmp(argv[i], "--language") == 0) {
+            options.language = parse_string_argument(argc, argv, &i);
+        } else if (strcmp(argv[i], "--resource-dir") == 0) {
+            options.resource_path = parse_string_argument(argc, argv, &i);
+        } else if (strcmp(argv[i], "--include") == 0 && options.include_path_count < MAX_INCLUDE_PATHS) {
+            options.include_paths[options.include_path_count++] = parse_string_argument(argc, argv, &i);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (i >= argc || options.iterations < 1) {
+        print_usage();
+        return 1;
+    }
+
+    for (; i < argc; ++i) {
+        bench_header(argv[i], &options);
+    }
+
+    printf("peak rss: %lld KiB\n", peak_rss_kb());
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "generate") == 0) {
+        return generate(argc - 2, argv + 2);
+    }
+    if (argc > 1 && strcmp(argv[1], "run") == 0) {
+        return run(argc - 2, argv + 2);
+    }
+    print_usage();
+    return 1;
+}
@@ -0,0 +1,15 @@
+#ifndef RESECT_BENCH_H
+#define RESECT_BENCH_H
+
+#include <stdio.h>
+
+typedef struct {
+    int decl_count;
+    int template_depth;
+    int overload_count;
+    int namespace_depth;
+} resect_bench_generator_options;
+
+void resect_bench_generate(FILE *out, const resect_bench_generator_options *options);
+
+#endif //RESECT_BENCH_H
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+static void print_indent(FILE *out, int level) {
+    for (int i = 0; i < level; ++i) {
+        fputs("    ", out);
+    }
+}
+
+static void generate_template_chain(FILE *out, int depth, int indent) {
+    if (depth <= 0) {
+        return;
+    }
+
+    print_indent(out, indent);
+    fprintf(out, "template<typename T>\n");
+    print_indent(out, indent);
+    fprintf(out, "struct Chain0 { T value; };\n\n");
+
+    for (int level = 1; level < depth; ++level) {
+        print_indent(out, indent);
+        fprintf(out, "template<typename T>\n");
+        print_indent(out, indent);
+        fprintf(out, "struct Chain%d { Chain%d<T> inner; Chain%d<T *> pointer_inner; };\n\n",
+                level, level - 1, level - 1);
+    }
+
+    print_indent(out, indent);
+    fprintf(out, "struct ChainRoot { Chain%d<int> chain; };\n\n", depth - 1);
+}
+
+static void generate_decls(FILE *out, const resect_bench_generator_options *options, int indent) {
+    for (int i = 0; i < options->decl_count; ++i) {
+        print_indent(out, indent);
+        fprintf(out, "struct Record%d {\n", i);
+        print_indent(out, indent + 1);
+        fprintf(out, "int id;\n");
+        print_indent(out, indent + 1);
+        fprintf(out, "double weight;\n");
+        if (i > 0) {
+            print_indent(out, indent + 1);
+            fprintf(out, "Record%d *previous;\n", i - 1);
+        }
+        print_indent(out, indent + 1);
+        fprintf(out, "int method%d(int value) const;\n", i);
+        print_indent(out, indent);
+        fprintf(out, "};\n\n");
+
+        print_indent(out, indent);
+        fprintf(out, "enum Kind%d { KIND%d_FIRST = %d, KIND%d_SECOND };\n\n", i, i, i, i);
+
+        for (int overload = 0; overload < options->overload_count; ++overload) {
+            print_indent(out, indent);
+            fprintf(out, "int function%d(Record%d *record", i, i);
+            for (int param = 0; param < overload; ++param) {
+                fprintf(out, ", %s arg%d", param % 2 == 0 ? "long" : "float", param);
+            }
+            fprintf(out, ");\n");
+        }
+        fputc('\n', out);
+    }
+}
+
+static void generate_namespace(FILE *out, const resect_bench_generator_options *options, int level) {
+    if (level >= options->namespace_depth) {
+        generate_template_chain(out, options->template_depth, level);
+        generate_decls(out, options, level);
+        return;
+    }
+
+    print_indent(out, level);
+    fprintf(out, "namespace bench%d {\n\n", level);
+    generate_namespace(out, options, level + 1);
+    print_indent(out, level);
+    fprintf(out, "}\n\n");
+}
+
+void resect_bench_generate(FILE *out, const resect_bench_generator_options *options) {
+    fprintf(out, "// generated by resect-bench: decls=%d template-depth=%d overloads=%d namespace-depth=%d\n",
+            options->decl_count, options->template_depth, options->overload_count, options->namespace_depth);
+    fprintf(out, "#pragma once\n\n");
+    generate_namespace(out, options, 0);
+}
@@ -12,6 +12,9 @@
 #else
 #  define RESECT_API
 #endif
+
+#include <stdio.h>
+
 #ifdef __cplusplus
 extern "C" {
 
@@ -231,6 +234,12 @@ typedef enum {
     RESECT_CONSTRUCTOR_KIND_OTHER = 5,
 } resect_constructor_kind;
 
+typedef enum {
+    RESECT_SYMBOL_STATUS_UNKNOWN = 0,
+    RESECT_SYMBOL_STATUS_AVAILABLE = 1,
+    RESECT_SYMBOL_STATUS_MISSING = 2,
+} resect_symbol_status;
+
 typedef struct P_resect_translation_unit *resect_translation_unit;
 typedef struct P_resect_collection *resect_collection;
 typedef struct P_resect_iterator *resect_iterator;
@@ -240,6 +249,31 @@ typedef struct P_resect_type *resect_type;
 typedef struct P_resect_template_argument *resect_template_argument;
 typedef struct P_resect_type_field *resect_type_field;
 typedef struct P_resect_type_method *resect_type_method;
+typedef struct P_resect_mapped_unit *resect_mapped_unit;
+typedef struct P_resect_decl_group *resect_decl_group;
+typedef const struct P_resect_mapped_decl *resect_mapped_decl;
+typedef const struct P_resect_mapped_type *resect_mapped_type;
+
+typedef void (*resect_decl_consumer)(resect_decl decl, void *user_data);
+
+typedef enum {
+    RESECT_PHASE_CLANG_PARSE = 0,
+    RESECT_PHASE_SHAKING = 1,
+    RESECT_PHASE_REGISTRY_INIT = 2,
+    RESECT_PHASE_PARSE = 3,
+    RESECT_PHASE_TEARDOWN = 4,
+} resect_phase;
+
+typedef enum {
+    RESECT_COUNTER_CURSORS_VISITED = 0,
+    RESECT_COUNTER_DECL_GRAPH_NODES = 1,
+    RESECT_COUNTER_DECL_GRAPH_EDGES = 2,
+    RESECT_COUNTER_TYPES_CREATED = 3,
+    RESECT_COUNTER_REGISTRY_HITS = 4,
+    RESECT_COUNTER_REGISTRY_MISSES = 5,
+    RESECT_COUNTER_PATTERN_MATCHES = 6,
+    RESECT_COUNTER_BYTES_ALLOCATED = 7,
+} resect_counter;
 
 /*
  * COLLECTION
@@ -278,6 +312,8 @@ RESECT_API long long resect_type_offsetof(resect_type type, const char *field_na
 
 RESECT_API resect_collection resect_type_fields(resect_type type);
 
+RESECT_API resect_type_field resect_type_field_at(resect_type type, unsigned int index);
+
 RESECT_API resect_collection resect_type_base_classes(resect_type type);
 
 RESECT_API resect_collection resect_type_methods(resect_type type);
@@ -296,6 +332,10 @@ RESECT_API resect_collection resect_type_template_arguments(resect_type type);
 
 RESECT_API resect_bool resect_type_is_undeclared(resect_type type);
 
+RESECT_API resect_bool resect_type_is_truncated(resect_type type);
+
+RESECT_API resect_bool resect_type_is_opaque(resect_type type);
+
 RESECT_API const char *resect_type_field_get_id(resect_type_field field);
 
 RESECT_API const char *resect_type_field_get_name(resect_type_field field);
@@ -320,6 +360,8 @@ RESECT_API resect_type resect_type_method_get_proto(resect_type_method method);
 
 RESECT_API resect_decl resect_type_method_get_decl(resect_type_method method);
 
+RESECT_API resect_symbol_status resect_type_method_get_symbol_status(resect_type_method method);
+
 /*
  * TEMPLATE ARGUMENT
  */
@@ -394,6 +436,10 @@ RESECT_API resect_collection resect_decl_template_parameters(resect_decl decl);
 
 RESECT_API resect_collection resect_decl_template_specializations(resect_decl decl);
 
+RESECT_API resect_collection resect_decl_dependencies(resect_decl decl);
+
+RESECT_API resect_collection resect_decl_dependents(resect_decl decl);
+
 RESECT_API resect_type resect_decl_get_type(resect_decl decl);
 
 RESECT_API resect_decl resect_decl_get_owner(resect_decl decl);
@@ -406,6 +452,8 @@ RESECT_API resect_linkage_kind resect_decl_get_linkage(resect_decl decl);
 
 RESECT_API resect_bool resect_decl_is_forward(resect_decl decl);
 
+RESECT_API resect_symbol_status resect_decl_get_symbol_status(resect_decl decl);
+
 /*
  * TRANSLATION UNIT
  */
@@ -413,6 +461,103 @@ RESECT_API resect_collection resect_unit_declarations(resect_translation_unit un
 
 RESECT_API resect_language resect_unit_get_language(resect_translation_unit unit);
 
+RESECT_API resect_bool resect_unit_save(resect_translation_unit unit, const char *path);
+
+RESECT_API resect_translation_unit resect_unit_load(const char *path);
+
+RESECT_API resect_bool resect_unit_check_symbols(resect_translation_unit unit, const char *library_path);
+
+RESECT_API resect_decl resect_unit_find_decl_by_id(resect_translation_unit unit, const char *id);
+
+RESECT_API resect_decl resect_unit_find_decl_by_name(resect_translation_unit unit, const char *qualified_name);
+
+RESECT_API resect_collection resect_unit_declarations_sorted(resect_translation_unit unit);
+
+RESECT_API resect_collection resect_decl_group_declarations(resect_decl_group group);
+
+RESECT_API resect_bool resect_decl_group_is_cyclic(resect_decl_group group);
+
+RESECT_API resect_bool resect_unit_write_json(resect_translation_unit unit, FILE *out);
+
+RESECT_API double resect_unit_phase_wall_time(resect_translation_unit unit, resect_phase phase);
+
+RESECT_API double resect_unit_phase_cpu_time(resect_translation_unit unit, resect_phase phase);
+
+RESECT_API unsigned long long resect_unit_counter(resect_translation_unit unit, resect_counter counter);
+
+/*
+ * MAPPED UNIT
+ */
+RESECT_API resect_mapped_unit resect_unit_map(const char *path);
+
+RESECT_API void resect_unit_unmap(resect_mapped_unit unit);
+
+RESECT_API resect_language resect_mapped_unit_get_language(resect_mapped_unit unit);
+
+RESECT_API unsigned int resect_mapped_unit_declaration_count(resect_mapped_unit unit);
+
+RESECT_API resect_mapped_decl resect_mapped_unit_declaration(resect_mapped_unit unit, unsigned int index);
+
+RESECT_API resect_decl_kind resect_mapped_decl_get_kind(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API const char *resect_mapped_decl_get_id(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API const char *resect_mapped_decl_get_name(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API const char *resect_mapped_decl_get_namespace(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API const char *resect_mapped_decl_get_mangled_name(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API const char *resect_mapped_decl_get_comment(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API const char *resect_mapped_decl_get_source(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API const char *resect_mapped_decl_get_location_name(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API unsigned int resect_mapped_decl_get_location_line(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API unsigned int resect_mapped_decl_get_location_column(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API resect_access_specifier resect_mapped_decl_get_access_specifier(resect_mapped_unit unit,
+                                                                          resect_mapped_decl decl);
+
+RESECT_API resect_linkage_kind resect_mapped_decl_get_linkage(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API resect_bool resect_mapped_decl_is_template(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API resect_bool resect_mapped_decl_is_forward(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API resect_symbol_status resect_mapped_decl_get_symbol_status(resect_mapped_unit unit,
+                                                                    resect_mapped_decl decl);
+
+RESECT_API resect_mapped_decl resect_mapped_decl_get_owner(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API resect_mapped_decl resect_mapped_decl_get_template(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API resect_mapped_type resect_mapped_decl_get_type(resect_mapped_unit unit, resect_mapped_decl decl);
+
+RESECT_API resect_type_kind resect_mapped_type_get_kind(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API const char *resect_mapped_type_get_name(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API long long resect_mapped_type_sizeof(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API long long resect_mapped_type_alignof(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API resect_type_category resect_mapped_type_get_category(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API resect_bool resect_mapped_type_is_const_qualified(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API resect_bool resect_mapped_type_is_pod(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API resect_bool resect_mapped_type_is_undeclared(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API resect_bool resect_mapped_type_is_truncated(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API resect_bool resect_mapped_type_is_opaque(resect_mapped_unit unit, resect_mapped_type type);
+
+RESECT_API resect_mapped_decl resect_mapped_type_get_declaration(resect_mapped_unit unit, resect_mapped_type type);
+
 /*
  * RECORD
  */
@@ -422,6 +567,17 @@ RESECT_API resect_bool resect_field_decl_is_bitfield(resect_decl decl);
 
 RESECT_API long long resect_field_decl_get_width(resect_decl decl);
 
+typedef struct {
+    const char *name;
+    long long offset;
+    long long width;
+    resect_type_kind type_kind;
+    long long type_size;
+} resect_field_layout;
+
+RESECT_API unsigned int resect_record_layout(resect_decl decl, resect_field_layout *layout, unsigned int capacity,
+                                             resect_bool flatten_anonymous);
+
 RESECT_API resect_collection resect_record_fields(resect_decl decl);
 
 RESECT_API resect_collection resect_record_methods(resect_decl decl);
@@ -501,15 +657,40 @@ RESECT_API resect_bool resect_method_is_deleted(resect_decl decl);
  */
 RESECT_API resect_bool resect_macro_is_function_like(resect_decl decl);
 
+RESECT_API resect_variable_kind resect_macro_get_value_kind(resect_decl decl);
+
+RESECT_API long long resect_macro_get_value_as_int(resect_decl decl);
+
+RESECT_API double resect_macro_get_value_as_float(resect_decl decl);
+
+RESECT_API const char *resect_macro_get_value_as_string(resect_decl decl);
+
 /*
  * TEMPLATE PARAMETER
  */
 RESECT_API resect_template_parameter_kind resect_template_parameter_get_kind(resect_decl param);
 
+/*
+ * MEMORY
+ */
+typedef void *(*resect_malloc_fn)(size_t size, void *user_data);
+typedef void *(*resect_realloc_fn)(void *ptr, size_t size, void *user_data);
+typedef void (*resect_free_fn)(void *ptr, void *user_data);
+
+// blocks are always released through the allocator that created them, so the allocator can only be swapped
+// while no libresect object is alive: returns false and keeps the current one if resect_allocated_bytes() != 0
+RESECT_API resect_bool resect_set_allocator(resect_malloc_fn malloc_fn, resect_realloc_fn realloc_fn,
+                                            resect_free_fn free_fn, void *user_data);
+
+RESECT_API unsigned long long resect_allocated_bytes();
+
+RESECT_API unsigned long long resect_peak_allocated_bytes();
+
 /*
  * PARSE OPTIONS
  */
 typedef struct P_resect_parse_options *resect_parse_options;
+typedef struct P_resect_unsaved_files *resect_unsaved_files;
 
 RESECT_API resect_parse_options resect_options_create();
 
@@ -529,6 +710,10 @@ RESECT_API void resect_options_ignore_definition(resect_parse_options opts, cons
 
 RESECT_API void resect_options_ignore_source(resect_parse_options opts, const char *source);
 
+RESECT_API void resect_options_root_definition(resect_parse_options opts, const char *name);
+
+RESECT_API void resect_options_root_hop_limit(resect_parse_options opts, unsigned int hops);
+
 RESECT_API void resect_options_add_resource_path(resect_parse_options opts, const char *path);
 
 RESECT_API void resect_options_add_include_path(resect_parse_options opts, const char *path);
@@ -555,6 +740,29 @@ RESECT_API void resect_options_add_intrinsics(resect_parse_options opts, const c
 
 RESECT_API void resect_options_single_header(resect_parse_options opts);
 
+RESECT_API void resect_options_sort_by_location(resect_parse_options opts);
+
+RESECT_API void resect_options_reparseable(resect_parse_options opts);
+
+RESECT_API void resect_options_memory_limit(resect_parse_options opts, unsigned long long bytes);
+
+RESECT_API void resect_options_template_depth_limit(resect_parse_options opts, unsigned int depth);
+
+RESECT_API void resect_options_specialization_limit(resect_parse_options opts, unsigned int count);
+
+RESECT_API void resect_options_parallel(resect_parse_options opts, unsigned int workers);
+
+RESECT_API void resect_options_opaque_through_pointers(resect_parse_options opts);
+
+RESECT_API void resect_options_public_only(resect_parse_options opts);
+
+RESECT_API void resect_options_skip_evaluation(resect_parse_options opts);
+
+RESECT_API void resect_options_evaluate_macros(resect_parse_options opts);
+
+RESECT_API void resect_options_add_unsaved_file(resect_parse_options opts, const char *path,
+                                                const char *contents, unsigned long length);
+
 RESECT_API void resect_options_print_diagnostics(resect_parse_options opts);
 
 RESECT_API void resect_options_diagnostics_level(resect_parse_options opts, resect_diagnostics_level level);
@@ -563,11 +771,31 @@ RESECT_API void resect_options_intrinsic(resect_parse_options opts, resect_optio
 
 RESECT_API void resect_options_free(resect_parse_options opts);
 
+/*
+ * UNSAVED FILES
+ */
+RESECT_API resect_unsaved_files resect_unsaved_files_create();
+
+RESECT_API void resect_unsaved_files_add(resect_unsaved_files files, const char *filename,
+                                         const char *contents, unsigned long length);
+
+RESECT_API void resect_unsaved_files_free(resect_unsaved_files files);
+
 /*
  * PARSER
  */
 RESECT_API resect_translation_unit resect_parse(const char *filename, resect_parse_options options);
 
+RESECT_API resect_translation_unit resect_parse_stream(const char *filename, resect_parse_options options,
+                                                       resect_decl_consumer consumer, void *user_data);
+
+// only decls located in files changed since the last parse, decls no longer included and decls referring to
+// either are materialized again, handles to every other decl and to its type stay valid and are found again as is.
+// Handles to decls materialized again stay readable until resect_free(), but the unit no longer refers to them.
+// If anything changed, collections returned by resect_unit_declarations() and resect_unit_declarations_sorted()
+// are released and declarations of changed files come after the kept ones, unless they are sorted by location.
+RESECT_API resect_bool resect_reparse(resect_translation_unit unit, resect_unsaved_files unsaved_files);
+
 RESECT_API void resect_free(resect_translation_unit result);
 
 #ifdef __csplusplus
@@ -20,7 +20,7 @@ typedef struct P_resect_type_registry {
 
 
 resect_type_registry resect_type_registry_create() {
-    resect_type_registry registry = malloc(sizeof(struct P_resect_type_registry));
+    resect_type_registry registry = resect_allocate(sizeof(struct P_resect_type_registry));
     registry->type_stack_table = resect_table_create();
     return registry;
 }
@@ -30,7 +30,7 @@ void resect_type_registry_table_stack_destructor(void *context, void *value) {
     resect_iterator iter = resect_collection_iterator(type_stack);
     while (resect_iterator_next(iter)) {
         P_resect_type_stack_value *stack = resect_iterator_value(iter);
-        free(stack);
+        resect_deallocate(stack);
     }
     resect_iterator_free(iter);
     resect_collection_free(type_stack);
@@ -42,7 +42,7 @@ void resect_type_registry_table_stack_destructor(void *context, void *value) {
  */
 void resect_type_registry_free(resect_type_registry registry) {
     resect_table_free(registry->type_stack_table, resect_type_registry_table_stack_destructor, NULL);
-    free(registry);
+    resect_deallocate(registry);
 }
 
 bool resect_type_registry_add(resect_type_registry registry, resect_string type_fqn,
@@ -65,7 +65,7 @@ bool resect_type_registry_add(resect_type_registry registry, resect_string type_
         }
     }
 
-    P_resect_type_stack_value* new_value = malloc(sizeof(P_resect_type_stack_value));
+    P_resect_type_stack_value* new_value = resect_allocate(sizeof(P_resect_type_stack_value));
     new_value->clang_type = clang_type;
     new_value->resect_type = resect_type;
     resect_collection_add(type_stack, new_value);
@@ -99,24 +99,91 @@ done:
     return result;
 }
 
+/*
+ * REGISTRY
+ */
+// decls and types materialized by every context sharing the registry
+typedef struct P_resect_registry {
+    resect_concurrent_table decl_table;
+    // declared types keyed by decl id and type name, unlike clang types these are the same for every worker
+    resect_concurrent_table type_table;
+    resect_set exposed_decls;
+    resect_collection garbage;
+    // object-like macros awaiting evaluation, handed to the consumer only after it
+    resect_collection macros;
+    resect_language language;
+
+    resect_memory_account memory_account;
+
+    // NULL unless parallel workers share the registry, guards everything but the tables, which lock themselves
+    resect_mutex lock;
+    resect_condition built;
+    // build state each worker waits on, NULL while it doesn't wait
+    volatile unsigned int **awaited;
+    unsigned int worker_count;
+} *resect_registry;
+
+static resect_registry resect_registry_create(unsigned int worker_count, unsigned long long memory_limit) {
+    bool shared = worker_count > 1;
+
+    resect_registry registry = resect_allocate(sizeof(struct P_resect_registry));
+    registry->decl_table = resect_concurrent_table_create(shared);
+    registry->type_table = resect_concurrent_table_create(shared);
+    registry->exposed_decls = resect_set_create();
+    registry->garbage = resect_collection_create();
+    registry->macros = resect_collection_create();
+    registry->language = RESECT_LANGUAGE_UNKNOWN;
+
+    registry->memory_account = memory_limit != 0 ? resect_memory_account_create() : NULL;
+
+    registry->lock = shared ? resect_mutex_create() : NULL;
+    registry->built = shared ? resect_condition_create() : NULL;
+    registry->awaited = resect_allocate(worker_count * sizeof(volatile unsigned int *));
+    memset(registry->awaited, 0, worker_count * sizeof(volatile unsigned int *));
+    registry->worker_count = worker_count;
+
+    return registry;
+}
+
 /*
  * TRANSLATION CONTEXT
 */
 struct P_resect_translation_context {
-    resect_set exposed_decls;
-    resect_table decl_table;
+    resect_registry registry;
+    // registry is freed along with the context that created it
+    bool owns_registry;
+    // id of the worker materializing decls through this context, starting from 1
+    unsigned int worker;
+
     resect_type_registry type_registry;
     resect_table template_parameter_table;
-    resect_language language;
 
     resect_inclusion_registry inclusion_registry;
 
-    resect_collection garbage;
-
     CXPrintingPolicy printing_policy;
 
     resect_pattern decl_name_pattern;
     resect_diagnostics_level diagnostics_level;
+
+    resect_decl_consumer decl_consumer;
+    void *decl_consumer_data;
+    resect_collection pending_exposed_decls;
+    unsigned int decl_depth;
+
+    resect_stats stats;
+
+    unsigned long long memory_threshold;
+
+    unsigned int template_depth;
+    unsigned int template_depth_limit;
+    unsigned int specialization_limit;
+
+    bool opaque_through_pointers;
+    unsigned int pointee_depth;
+
+    bool public_only;
+    bool skip_evaluation;
+    bool evaluate_macros;
 };
 
 struct P_resect_garbage {
@@ -124,27 +191,77 @@ struct P_resect_garbage {
     void *data;
 };
 
-resect_translation_context resect_context_create(resect_parse_options opts,
-                                                 resect_inclusion_registry registry) {
-    resect_translation_context context = malloc(sizeof(struct P_resect_translation_context));
-    context->exposed_decls = resect_set_create();
-    context->decl_table = resect_table_create();
+static unsigned long long get_memory_limit(resect_parse_options opts) {
+    return opts != NULL ? resect_options_current_memory_limit(opts) : 0;
+}
+
+static resect_translation_context create_context(resect_parse_options opts,
+                                                 resect_inclusion_registry inclusion_registry,
+                                                 resect_registry registry,
+                                                 unsigned int worker) {
+    resect_translation_context context = resect_allocate(sizeof(struct P_resect_translation_context));
+    context->registry = registry;
+    context->owns_registry = worker == 1;
+    context->worker = worker;
+
     context->type_registry = resect_type_registry_create();
     context->template_parameter_table = resect_table_create();
-    context->language = RESECT_LANGUAGE_UNKNOWN;
 
-    context->inclusion_registry = registry;
+    context->inclusion_registry = inclusion_registry;
 
-    context->garbage = resect_collection_create();
     context->printing_policy = NULL;
 
     context->decl_name_pattern = resect_pattern_create_c("^operator.+|[~\\w]+");
 
-    context->diagnostics_level = resect_options_current_diagnostics_level(opts);
+    // units restored from serialized form have no options
+    context->diagnostics_level = opts != NULL
+                                     ? resect_options_current_diagnostics_level(opts)
+                                     : RESECT_DIAGNOSTICS_NONE;
+
+    context->decl_consumer = NULL;
+    context->decl_consumer_data = NULL;
+    context->pending_exposed_decls = resect_collection_create();
+    context->decl_depth = 0;
+
+    context->stats = NULL;
+
+    // stop expanding a bit before the limit, so decls already in progress can still be completed
+    unsigned long long memory_limit = get_memory_limit(opts);
+    context->memory_threshold = memory_limit - memory_limit / 10;
+
+    context->template_depth = 0;
+    context->template_depth_limit = opts != NULL ? resect_options_current_template_depth_limit(opts) : 0;
+    context->specialization_limit = opts != NULL ? resect_options_current_specialization_limit(opts) : 0;
+
+    context->opaque_through_pointers = opts != NULL && resect_options_current_opaque_through_pointers(opts);
+    context->pointee_depth = 0;
+
+    context->public_only = opts != NULL && resect_options_current_public_only(opts);
+    context->skip_evaluation = opts != NULL && resect_options_current_skip_evaluation(opts);
+    context->evaluate_macros = opts != NULL && resect_options_current_evaluate_macros(opts);
 
     return context;
 }
 
+resect_translation_context resect_context_create(resect_parse_options opts,
+                                                 resect_inclusion_registry registry) {
+    return create_context(opts, registry, resect_registry_create(1, get_memory_limit(opts)), 1);
+}
+
+resect_translation_context resect_context_create_shared(resect_parse_options opts,
+                                                        resect_inclusion_registry registry,
+                                                        unsigned int worker_count) {
+    assert(worker_count > 0);
+    return create_context(opts, registry, resect_registry_create(worker_count, get_memory_limit(opts)), 1);
+}
+
+resect_translation_context resect_context_create_worker(resect_translation_context context,
+                                                        resect_parse_options opts,
+                                                        unsigned int worker_index) {
+    assert(worker_index > 0 && worker_index < context->registry->worker_count);
+    return create_context(opts, context->inclusion_registry, context->registry, worker_index + 1);
+}
+
 void resect_decl_table_free(void *context, void *value) {
     resect_set deallocated = context;
     resect_decl decl = value;
@@ -177,46 +294,248 @@ static void free_garbage_collection(resect_collection garbage_collection, resect
                 // FIXME: add better error reporting
                 assert(!"Unexpected garbage kind");
         }
+        resect_deallocate(garbage);
     }
     resect_iterator_free(iter);
     resect_collection_free(garbage_collection);
 }
 
+static void resect_registry_free(resect_registry registry, resect_set deallocated) {
+    resect_concurrent_table_free(registry->decl_table, resect_decl_table_free, deallocated);
+    resect_concurrent_table_free(registry->type_table, resect_type_table_free, deallocated);
+
+    resect_set_free(registry->exposed_decls);
+    resect_collection_free(registry->macros);
+
+    free_garbage_collection(registry->garbage, deallocated);
+
+    if (registry->memory_account != NULL) {
+        resect_memory_account_free(registry->memory_account);
+    }
+    if (registry->lock != NULL) {
+        resect_condition_free(registry->built);
+        resect_mutex_free(registry->lock);
+    }
+    resect_deallocate(registry->awaited);
+    resect_deallocate(registry);
+}
+
 void resect_context_free(resect_translation_context context, resect_set deallocated) {
     if (!resect_set_add(deallocated, context)) {
         return;
     }
 
-    resect_table_free(context->decl_table, resect_decl_table_free, deallocated);
+    if (context->owns_registry) {
+        resect_registry_free(context->registry, deallocated);
+    }
     resect_type_registry_free(context->type_registry);
     resect_table_free(context->template_parameter_table, NULL, NULL);
 
-    resect_set_free(context->exposed_decls);
-
-    free_garbage_collection(context->garbage, deallocated);
+    resect_collection_free(context->pending_exposed_decls);
 
     resect_pattern_free(context->decl_name_pattern);
 
-    free(context);
+    resect_deallocate(context);
+}
+
+static resect_bool update_decl_symbol_status(void *ctx, const char *id, void *value) {
+    resect_decl_update_symbol_status(value, ctx);
+    return resect_true;
+}
+
+void resect_context_update_symbol_status(resect_translation_context context, resect_symbol_table symbols) {
+    resect_visit_concurrent_table(context->registry->decl_table, update_decl_symbol_status, symbols);
+}
+
+static resect_bool collect_registered_decl(void *ctx, const char *id, void *value) {
+    resect_collection_add(ctx, value);
+    return resect_true;
+}
+
+resect_collection resect_context_registered_decls(resect_translation_context context) {
+    resect_collection collection = resect_collection_create();
+    resect_visit_concurrent_table(context->registry->decl_table, collect_registered_decl, collection);
+    return collection;
+}
+
+resect_decl resect_context_find_registered_decl(resect_translation_context context, const char *decl_id) {
+    return resect_concurrent_table_get(context->registry->decl_table, decl_id);
+}
+
+void resect_context_set_inclusion_registry(resect_translation_context context,
+                                          resect_inclusion_registry inclusion_registry) {
+    context->inclusion_registry = inclusion_registry;
 }
 
 bool resect_is_decl_included(resect_translation_context context, resect_string decl_id) {
     return resect_inclusion_registry_decl_included(context->inclusion_registry, resect_string_to_c(decl_id));
 }
 
+void resect_context_lock(resect_translation_context context) {
+    if (context->registry->lock != NULL) {
+        resect_mutex_lock(context->registry->lock);
+    }
+}
+
+void resect_context_unlock(resect_translation_context context) {
+    if (context->registry->lock != NULL) {
+        resect_mutex_unlock(context->registry->lock);
+    }
+}
+
+static bool is_evaluated_macro(resect_decl decl) {
+    return resect_decl_get_kind(decl) == RESECT_DECL_KIND_MACRO && resect_macro_body(decl)[0] != '\0';
+}
+
 void resect_expose_decl(resect_translation_context context, resect_decl decl) {
-    resect_set_add(context->exposed_decls, decl);
+    resect_context_lock(context);
+    bool exposed = resect_set_add(context->registry->exposed_decls, decl);
+    resect_context_unlock(context);
+
+    if (exposed && context->decl_consumer != NULL && !is_evaluated_macro(decl)) {
+        resect_collection_add(context->pending_exposed_decls, decl);
+    }
+}
+
+void resect_context_add_macro(resect_translation_context context, resect_decl macro) {
+    resect_context_lock(context);
+    resect_collection_add(context->registry->macros, macro);
+    resect_context_unlock(context);
+}
+
+resect_collection resect_context_macros(resect_translation_context context) { return context->registry->macros; }
+
+void resect_context_release_macros(resect_translation_context context) {
+    resect_registry registry = context->registry;
+    if (context->decl_consumer != NULL) {
+        resect_iterator iter = resect_collection_iterator(registry->macros);
+        while (resect_iterator_next(iter)) {
+            resect_decl macro = resect_iterator_value(iter);
+            // same as other decls, only exposed macros reach the consumer
+            if (resect_set_contains(registry->exposed_decls, macro)) {
+                context->decl_consumer(macro, context->decl_consumer_data);
+            }
+        }
+        resect_iterator_free(iter);
+    }
+
+    resect_collection_free(registry->macros);
+    registry->macros = resect_collection_create();
+}
+
+void resect_context_set_stats(resect_translation_context context, resect_stats stats) {
+    context->stats = stats;
+}
+
+resect_stats resect_context_stats(resect_translation_context context) {
+    return context->stats;
+}
+
+resect_memory_account resect_context_memory_account(resect_translation_context context) {
+    return context->registry->memory_account;
+}
+
+bool resect_context_memory_exhausted(resect_translation_context context) {
+    resect_memory_account account = context->registry->memory_account;
+    if (account == NULL) {
+        return false;
+    }
+    return resect_memory_account_allocated(account) >= context->memory_threshold;
+}
+
+void resect_context_enter_template_arguments(resect_translation_context context) {
+    ++context->template_depth;
+}
+
+void resect_context_leave_template_arguments(resect_translation_context context) {
+    assert(context->template_depth > 0);
+    --context->template_depth;
+}
+
+bool resect_context_template_depth_exceeded(resect_translation_context context) {
+    return context->template_depth_limit > 0 && context->template_depth >= context->template_depth_limit;
+}
+
+void resect_context_enter_pointee(resect_translation_context context) {
+    ++context->pointee_depth;
+}
+
+void resect_context_leave_pointee(resect_translation_context context) {
+    assert(context->pointee_depth > 0);
+    --context->pointee_depth;
+}
+
+unsigned int resect_context_suspend_pointee(resect_translation_context context) {
+    unsigned int depth = context->pointee_depth;
+    context->pointee_depth = 0;
+    return depth;
+}
+
+void resect_context_resume_pointee(resect_translation_context context, unsigned int depth) {
+    context->pointee_depth = depth;
+}
+
+bool resect_context_opaque_pointee(resect_translation_context context) {
+    return context->opaque_through_pointers && context->pointee_depth > 0;
+}
+
+bool resect_context_public_only(resect_translation_context context) {
+    return context->public_only;
+}
+
+bool resect_context_skip_evaluation(resect_translation_context context) {
+    return context->skip_evaluation;
+}
+
+bool resect_context_evaluate_macros(resect_translation_context context) {
+    return context->evaluate_macros && !context->skip_evaluation;
+}
+
+bool resect_context_specialization_limit_reached(resect_translation_context context,
+                                                 unsigned int specialization_count) {
+    return context->specialization_limit > 0 && specialization_count >= context->specialization_limit;
+}
+
+void resect_context_set_decl_consumer(resect_translation_context context, resect_decl_consumer consumer,
+                                      void *user_data) {
+    context->decl_consumer = consumer;
+    context->decl_consumer_data = user_data;
+}
+
+void resect_context_enter_decl(resect_translation_context context) {
+    ++context->decl_depth;
+}
+
+void resect_context_leave_decl(resect_translation_context context) {
+    assert(context->decl_depth > 0);
+    if (--context->decl_depth > 0 || context->decl_consumer == NULL) {
+        return;
+    }
+
+    // top-level decl is complete along with every decl it pulled in, so all of them can be handed out now
+    resect_collection pending = context->pending_exposed_decls;
+    context->pending_exposed_decls = resect_collection_create();
+
+    resect_iterator iter = resect_collection_iterator(pending);
+    while (resect_iterator_next(iter)) {
+        context->decl_consumer(resect_iterator_value(iter), context->decl_consumer_data);
+    }
+    resect_iterator_free(iter);
+    resect_collection_free(pending);
 }
 
 void resect_register_decl_language(resect_translation_context context, resect_language language) {
-    if (context->language == RESECT_LANGUAGE_UNKNOWN
-        || context->language == RESECT_LANGUAGE_C && language != RESECT_LANGUAGE_C) {
-        context->language = language;
+    resect_registry registry = context->registry;
+    resect_context_lock(context);
+    if (registry->language == RESECT_LANGUAGE_UNKNOWN
+        || registry->language == RESECT_LANGUAGE_C && language != RESECT_LANGUAGE_C) {
+        registry->language = language;
     }
+    resect_context_unlock(context);
 }
 
 resect_language resect_get_assumed_language(resect_translation_context context) {
-    return context->language;
+    return context->registry->language;
 }
 
 resect_string resect_format_cursor_source(CXCursor cursor) {
@@ -227,12 +546,15 @@ resect_string resect_format_cursor_source(CXCursor cursor) {
     return source;
 }
 
-void resect_register_decl(resect_translation_context context, resect_string decl_id, resect_decl decl) {
-    resect_table_put_if_absent(context->decl_table, resect_string_to_c(decl_id), decl);
+resect_decl resect_register_decl(resect_translation_context context, resect_string decl_id, resect_decl decl) {
+    return resect_concurrent_table_put_if_absent(context->registry->decl_table, resect_string_to_c(decl_id), decl);
 }
 
 resect_decl resect_find_decl(resect_translation_context context, resect_string decl_id) {
-    return resect_table_get(context->decl_table, resect_string_to_c(decl_id));
+    resect_decl result = resect_concurrent_table_get(context->registry->decl_table, resect_string_to_c(decl_id));
+    resect_stats_count(context->stats,
+                       result != NULL ? RESECT_COUNTER_REGISTRY_HITS : RESECT_COUNTER_REGISTRY_MISSES, 1);
+    return result;
 }
 
 bool resect_register_type(resect_translation_context context, CXType clang_type, resect_type resect_type) {
@@ -246,9 +568,19 @@ resect_type resect_find_type(resect_translation_context context, CXType clang_ty
     resect_string fqn = resect_string_fqn_from_type(context, clang_type);
     resect_type result = resect_type_registry_find(context->type_registry, fqn, clang_type);
     resect_string_free(fqn);
+    resect_stats_count(context->stats,
+                       result != NULL ? RESECT_COUNTER_REGISTRY_HITS : RESECT_COUNTER_REGISTRY_MISSES, 1);
     return result;
 }
 
+resect_type resect_register_declared_type(resect_translation_context context, resect_string key, resect_type type) {
+    return resect_concurrent_table_put_if_absent(context->registry->type_table, resect_string_to_c(key), type);
+}
+
+resect_type resect_find_declared_type(resect_translation_context context, resect_string key) {
+    return resect_concurrent_table_get(context->registry->type_table, resect_string_to_c(key));
+}
+
 void resect_register_template_parameter(resect_translation_context context, resect_string name, resect_decl decl) {
     resect_table_put_if_absent(context->template_parameter_table, resect_string_to_c(name), decl);
 }
@@ -263,8 +595,11 @@ void resect_context_flush_template_parameters(resect_translation_context context
 }
 
 resect_collection resect_create_decl_collection(resect_translation_context context) {
+    // set iteration follows insertion order, so decls come out in the order they were exposed
     resect_collection collection = resect_collection_create();
-    resect_set_add_to_collection(context->exposed_decls, collection);
+    resect_context_lock(context);
+    resect_set_add_to_collection(context->registry->exposed_decls, collection);
+    resect_context_unlock(context);
     return collection;
 }
 
@@ -301,12 +636,14 @@ resect_diagnostics_level resect_context_diagnostics_level(resect_translation_con
 }
 
 void resect_register_garbage(resect_translation_context context, enum P_resect_garbage_kind kind, void *garbage) {
-    struct P_resect_garbage *garbage_holder = malloc(sizeof(struct P_resect_garbage));
+    struct P_resect_garbage *garbage_holder = resect_allocate(sizeof(struct P_resect_garbage));
 
     garbage_holder->kind = kind;
     garbage_holder->data = garbage;
 
-    resect_collection_add(context->garbage, garbage_holder);
+    resect_context_lock(context);
+    resect_collection_add(context->registry->garbage, garbage_holder);
+    resect_context_unlock(context);
 }
 
 bool resect_context_extract_valid_decl_name(resect_translation_context context,
@@ -315,11 +652,240 @@ bool resect_context_extract_valid_decl_name(resect_translation_context context,
     return resect_pattern_find(context->decl_name_pattern, name, out);
 }
 
+/*
+ * INVALIDATION
+ */
+typedef struct P_resect_invalidation {
+    resect_translation_context context;
+    resect_table changed_files;
+    resect_set decls;
+    resect_collection type_keys;
+    resect_collection types;
+} *resect_invalidation;
+
+static void invalidate_decl(resect_invalidation invalidation, resect_decl decl) {
+    if (!resect_set_add(invalidation->decls, decl)) {
+        return;
+    }
+
+    // parts are registered under their own ids, but they are materialized only along with the decl
+    resect_collection parts = resect_collection_create();
+    resect_decl_collect_parts(decl, parts);
+    resect_iterator iter = resect_collection_iterator(parts);
+    while (resect_iterator_next(iter)) {
+        invalidate_decl(invalidation, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+    resect_collection_free(parts);
+}
+
+static bool is_decl_outdated(resect_invalidation invalidation, resect_decl decl) {
+    resect_location location = resect_decl_get_location(decl);
+    if (location != NULL && resect_table_get(invalidation->changed_files, resect_location_name(location)) != NULL) {
+        return true;
+    }
+    // changes in other files can change what's reachable from roots
+    return !resect_inclusion_registry_decl_included(invalidation->context->inclusion_registry,
+                                                    resect_decl_get_id(decl));
+}
+
+static resect_bool collect_outdated_type(void *ctx, const char *key, void *value) {
+    resect_invalidation invalidation = ctx;
+    resect_decl decl = resect_type_get_declaration(value);
+    if (decl != NULL && resect_set_contains(invalidation->decls, decl)) {
+        resect_collection_add(invalidation->type_keys, resect_string_from_c(key));
+        resect_collection_add(invalidation->types, value);
+    }
+    return resect_true;
+}
+
+static void drop_outdated_types(resect_invalidation invalidation) {
+    resect_translation_context context = invalidation->context;
+    resect_visit_concurrent_table(context->registry->type_table, collect_outdated_type, invalidation);
+
+    resect_iterator key_iter = resect_collection_iterator(invalidation->type_keys);
+    while (resect_iterator_next(key_iter)) {
+        resect_string key = resect_iterator_value(key_iter);
+        resect_concurrent_table_remove(context->registry->type_table, resect_string_to_c(key));
+    }
+    resect_iterator_free(key_iter);
+
+    resect_iterator type_iter = resect_collection_iterator(invalidation->types);
+    while (resect_iterator_next(type_iter)) {
+        resect_type type = resect_iterator_value(type_iter);
+        resect_decl root_template = resect_decl_get_root_template(resect_type_get_declaration(type));
+        if (root_template != NULL && !resect_set_contains(invalidation->decls, root_template)) {
+            resect_decl_unregister_specialization(root_template, type);
+        }
+        resect_register_garbage(context, RESECT_GARBAGE_KIND_TYPE, type);
+    }
+    resect_iterator_free(type_iter);
+}
+
+unsigned int resect_context_invalidate(resect_translation_context context, resect_table changed_files) {
+    resect_registry registry = context->registry;
+    struct P_resect_invalidation invalidation = {
+        .context = context,
+        .changed_files = changed_files,
+        .decls = resect_set_create(),
+        .type_keys = resect_collection_create(),
+        .types = resect_collection_create()
+    };
+
+    resect_collection decls = resect_context_registered_decls(context);
+    resect_iterator iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(iter)) {
+        resect_decl decl = resect_iterator_value(iter);
+        if (is_decl_outdated(&invalidation, decl)) {
+            invalidate_decl(&invalidation, decl);
+        }
+    }
+    resect_iterator_free(iter);
+
+    // decls referring to dropped ones go too, parts have no edges of their own, so owners are checked as well
+    bool invalidated;
+    do {
+        invalidated = false;
+        iter = resect_collection_iterator(decls);
+        while (resect_iterator_next(iter)) {
+            resect_decl decl = resect_iterator_value(iter);
+            if (!resect_set_contains(invalidation.decls, decl) && resect_decl_refers_to_any(decl, invalidation.decls)) {
+                invalidate_decl(&invalidation, decl);
+                invalidated = true;
+            }
+        }
+        resect_iterator_free(iter);
+    } while (invalidated);
+
+    drop_outdated_types(&invalidation);
+
+    iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(iter)) {
+        resect_decl decl = resect_iterator_value(iter);
+        if (resect_set_contains(invalidation.decls, decl)) {
+            resect_concurrent_table_remove(registry->decl_table, resect_decl_get_id(decl));
+            resect_set_remove(registry->exposed_decls, decl);
+            // handles to dropped decls stay valid until the unit is freed
+            resect_register_garbage(context, RESECT_GARBAGE_KIND_DECL, decl);
+        } else {
+            // edges are linked anew from the next shaking graph
+            resect_decl_unlink_dependencies(decl);
+        }
+    }
+    resect_iterator_free(iter);
+    resect_collection_free(decls);
+
+    // clang types are only comparable within the translation unit they come from
+    resect_type_registry_free(context->type_registry);
+    context->type_registry = resect_type_registry_create();
+
+    unsigned int count = resect_set_size(invalidation.decls);
+    resect_string_collection_free(invalidation.type_keys);
+    resect_collection_free(invalidation.types);
+    resect_set_free(invalidation.decls);
+
+    return count;
+}
+
+/*
+ * BUILD OWNERSHIP
+ */
+void resect_context_begin_build(resect_translation_context context, volatile unsigned int *builder) {
+    // nobody else sees the decl or type before it's registered
+    *builder = context->worker;
+}
+
+void resect_context_end_build(resect_translation_context context, volatile unsigned int *builder) {
+    resect_registry registry = context->registry;
+    if (registry->lock == NULL) {
+        *builder = 0;
+        return;
+    }
+
+    resect_mutex_lock(registry->lock);
+    resect_store_release(builder, 0);
+    resect_condition_broadcast(registry->built);
+    resect_mutex_unlock(registry->lock);
+}
+
+/**
+ * Follows the chain of workers waiting on each other, starting from the one building a decl or type.
+ * Registry lock must be held.
+ */
+static bool is_waiting_on(resect_registry registry, unsigned int builder, unsigned int worker) {
+    for (unsigned int i = 0; i < registry->worker_count && builder != 0; ++i) {
+        if (builder == worker) {
+            return true;
+        }
+        volatile unsigned int *awaited = registry->awaited[builder - 1];
+        if (awaited == NULL) {
+            return false;
+        }
+        builder = *awaited;
+    }
+    return false;
+}
+
+/**
+ * Registry lock must be held.
+ * @return false if the builder waits on this worker, so it can't wait in turn
+ */
+static bool await_build(resect_translation_context context, volatile unsigned int *builder) {
+    resect_registry registry = context->registry;
+    unsigned int current;
+    while ((current = *builder) != 0 && current != context->worker) {
+        if (is_waiting_on(registry, current, context->worker)) {
+            return false;
+        }
+        registry->awaited[context->worker - 1] = builder;
+        resect_condition_wait(registry->built, registry->lock);
+        registry->awaited[context->worker - 1] = NULL;
+    }
+    return true;
+}
+
+bool resect_context_await_build(resect_translation_context context, volatile unsigned int *builder) {
+    resect_registry registry = context->registry;
+    if (registry->lock == NULL || resect_load_acquire(builder) == 0) {
+        return true;
+    }
+
+    resect_mutex_lock(registry->lock);
+    bool built = await_build(context, builder);
+    resect_mutex_unlock(registry->lock);
+    return built;
+}
+
+resect_build_claim resect_context_claim_build(resect_translation_context context, volatile unsigned int *builder) {
+    resect_registry registry = context->registry;
+    if (registry->lock == NULL) {
+        if (*builder == context->worker) {
+            return RESECT_BUILD_OWNED;
+        }
+        *builder = context->worker;
+        return RESECT_BUILD_CLAIMED;
+    }
+
+    resect_build_claim claim;
+    resect_mutex_lock(registry->lock);
+    if (!await_build(context, builder)) {
+        claim = RESECT_BUILD_BUSY;
+    } else if (*builder == context->worker) {
+        claim = RESECT_BUILD_OWNED;
+    } else {
+        resect_store_release(builder, context->worker);
+        claim = RESECT_BUILD_CLAIMED;
+    }
+    resect_mutex_unlock(registry->lock);
+    return claim;
+}
+
 /*
  * COMMON VISIT
 */
 typedef struct P_resect_visit_context {
     resect_declaration_visitor visitor;
+    resect_stats stats;
 } *resect_visit_context;
 
 typedef struct {
@@ -333,14 +899,15 @@ enum CXChildVisitResult resect_visit_cursor_child_for_declaration(CXCursor curso
                                                                   CXCursor parent,
                                                                   CXClientData data);
 
-resect_visit_context resect_visit_context_create(resect_declaration_visitor visitor) {
-    resect_visit_context context = malloc(sizeof(struct P_resect_visit_context));
+resect_visit_context resect_visit_context_create(resect_declaration_visitor visitor, resect_stats stats) {
+    resect_visit_context context = resect_allocate(sizeof(struct P_resect_visit_context));
     context->visitor = visitor;
+    context->stats = stats;
     return context;
 }
 
 void resect_visit_context_free(resect_visit_context context) {
-    free(context);
+    resect_deallocate(context);
 }
 
 void resect_visit_cursor_children(resect_visit_context context, CXCursor cursor, void *data) {
@@ -382,6 +949,8 @@ void resect_visit_cursor_for_declaration(resect_visit_context context, CXCursor
         return;
     }
 
+    resect_stats_count(context->stats, RESECT_COUNTER_CURSORS_VISITED, 1);
+
     resect_child_visitor_data visitor_data = {.context = context, .data = data};
 
     enum CXCursorKind cursor_kind = clang_getCursorKind(cursor);
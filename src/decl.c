@@ -27,7 +27,7 @@ resect_string resect_location_to_string(resect_location location) {
 }
 
 resect_location resect_location_from_cursor(CXCursor cursor) {
-    resect_location result = malloc(sizeof(struct P_resect_location));
+    resect_location result = resect_allocate(sizeof(struct P_resect_location));
 
     CXFile file;
     clang_getFileLocation(clang_getCursorLocation(cursor), &file, &result->line, &result->column, NULL);
@@ -39,7 +39,7 @@ resect_location resect_location_from_cursor(CXCursor cursor) {
 
 void resect_location_free(resect_location location) {
     resect_string_free(location->name);
-    free(location);
+    resect_deallocate(location);
 }
 
 /*
@@ -80,7 +80,7 @@ resect_template_argument_kind convert_template_argument_kind(enum CXTemplateArgu
 
 resect_template_argument resect_template_argument_create(resect_template_argument_kind kind, resect_type type,
                                                          long long int value, int arg_number) {
-    resect_template_argument arg = malloc(sizeof(struct P_resect_template_argument));
+    resect_template_argument arg = resect_allocate(sizeof(struct P_resect_template_argument));
 
     arg->position = arg_number;
     arg->kind = kind;
@@ -98,7 +98,7 @@ void resect_template_argument_free(resect_template_argument arg, resect_set deal
         resect_type_free(arg->type, deallocated);
     }
 
-    free(arg);
+    resect_deallocate(arg);
 }
 
 void resect_init_template_args_from_cursor(resect_visit_context visit_context, resect_translation_context context,
@@ -137,6 +137,48 @@ void resect_template_argument_collection_free(resect_collection args, resect_set
     resect_collection_free(args);
 }
 
+#define TEMPLATE_ARGUMENT_RECORD_SIZE (5)
+
+uint32_t resect_template_argument_collection_serialize(resect_collection args, resect_writer writer) {
+    unsigned int count = resect_collection_size(args);
+    uint32_t *values = resect_allocate(TEMPLATE_ARGUMENT_RECORD_SIZE * count * sizeof(uint32_t) + 1);
+
+    uint32_t *record = values;
+    resect_iterator iter = resect_collection_iterator(args);
+    while (resect_iterator_next(iter)) {
+        resect_template_argument arg = resect_iterator_value(iter);
+        record[0] = (uint32_t) arg->position;
+        record[1] = arg->kind;
+        record[2] = resect_writer_type(writer, arg->type);
+        record[3] = RESECT_LOW_BITS(arg->value);
+        record[4] = RESECT_HIGH_BITS(arg->value);
+        record += TEMPLATE_ARGUMENT_RECORD_SIZE;
+    }
+    resect_iterator_free(iter);
+
+    uint32_t first = resect_writer_block(writer, values, TEMPLATE_ARGUMENT_RECORD_SIZE * count);
+    resect_deallocate(values);
+    return first;
+}
+
+void resect_template_argument_collection_deserialize(resect_collection args, resect_reader reader,
+                                                     uint32_t first, uint32_t count) {
+    if (!resect_reader_check_range(reader, first, (uint64_t) TEMPLATE_ARGUMENT_RECORD_SIZE * count)) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t offset = first + i * TEMPLATE_ARGUMENT_RECORD_SIZE;
+        resect_template_argument arg = resect_template_argument_create(
+            resect_reader_value(reader, offset + 1),
+            resect_reader_type(reader, resect_reader_value(reader, offset + 2)),
+            (long long) RESECT_JOIN_BITS(resect_reader_value(reader, offset + 3),
+                                         resect_reader_value(reader, offset + 4)),
+            (int) resect_reader_value(reader, offset));
+        resect_collection_add(args, arg);
+    }
+}
+
 resect_template_argument_kind resect_template_argument_get_kind(resect_template_argument arg) { return arg->kind; }
 
 resect_type resect_template_argument_get_type(resect_template_argument arg) { return arg->type; }
@@ -180,11 +222,20 @@ struct P_resect_decl {
     resect_collection specializations;
     resect_set specialization_set;
 
+    // created on demand, unit loaded from serialized form has none
+    resect_collection dependencies;
+    resect_collection dependents;
+
     resect_decl owner;
     resect_type type;
 
     resect_string source;
 
+    resect_symbol_status symbol_status;
+
+    // id of the worker building the decl, 0 once it's built
+    volatile unsigned int builder;
+
     void *data;
     resect_data_deallocator data_deallocator;
 };
@@ -282,6 +333,17 @@ resect_bool resect_is_specialized(CXCursor cursor) {
     return resect_true;
 }
 
+resect_bool resect_is_public_member(CXCursor cursor) {
+    switch (clang_getCXXAccessSpecifier(cursor)) {
+        case CX_CXXProtected:
+        case CX_CXXPrivate:
+            return resect_false;
+        default:
+            // C records and non-members have no access specifier
+            return resect_true;
+    }
+}
+
 void resect_extract_decl_namespace(resect_collection namespace_queue, CXCursor cursor) {
     CXCursor parent = clang_getCursorSemanticParent(cursor);
     if (!clang_Cursor_isNull(parent)) {
@@ -485,6 +547,26 @@ void resect_decl_register_specialization(resect_decl decl, resect_type specializ
     resect_set_add(decl->specialization_set, specialization);
 }
 
+static void clear_collection(resect_collection collection) {
+    while (resect_collection_size(collection) > 0) {
+        resect_collection_pop_last(collection);
+    }
+}
+
+void resect_decl_unregister_specialization(resect_decl decl, resect_type specialization) {
+    if (!resect_set_remove(decl->specialization_set, specialization) || decl->specializations == NULL) {
+        return;
+    }
+
+    // collection might be handed out already, so it's refilled in place
+    clear_collection(decl->specializations);
+    resect_set_add_to_collection(decl->specialization_set, decl->specializations);
+}
+
+unsigned int resect_decl_specialization_count(resect_decl decl) {
+    return resect_set_size(decl->specialization_set);
+}
+
 resect_decl resect_decl_get_root_template(resect_decl decl) {
     if (resect_collection_size(decl->template_arguments) > 0) {
         return resect_decl_get_root_template(decl->template);
@@ -500,6 +582,11 @@ resect_decl resect_decl_get_root_template(resect_decl decl) {
 void resect_record_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
                         CXCursor cursor);
 
+void resect_record_complete(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
+                            CXCursor cursor);
+
+resect_bool resect_is_struct(resect_decl decl);
+
 void resect_enum_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
                       CXCursor cursor);
 
@@ -545,19 +632,21 @@ void resect_decl__create(resect_visit_context visit_context, resect_translation_
 
 
 resect_decl_visit_data resect_decl_visit_data_create(resect_translation_context context) {
-    resect_decl_visit_data data = malloc(sizeof(struct P_resect_decl_visit_data));
+    resect_decl_visit_data data = resect_allocate(sizeof(struct P_resect_decl_visit_data));
     data->context = context;
     data->result.kind = RESECT_DECL_KIND_UNKNOWN;
     data->result.decl = NULL;
     return data;
 }
 
-void resect_visit_decl_data_free(resect_decl_visit_data data) { free(data); }
+void resect_visit_decl_data_free(resect_decl_visit_data data) { resect_deallocate(data); }
 
 void resect_decl_parse(resect_visit_context visit_context, CXCursor cursor, void *data) {
     resect_decl_visit_data visit_data = data;
+    resect_context_enter_decl(visit_data->context);
     resect_decl__create(visit_context, visit_data->context, cursor, &visit_data->result);
     resect_context_flush_template_parameters(visit_data->context);
+    resect_context_leave_decl(visit_data->context);
 }
 
 resect_decl_result resect_decl_create(resect_visit_context visit_context, resect_translation_context context,
@@ -568,6 +657,18 @@ resect_decl_result resect_decl_create(resect_visit_context visit_context, resect
     return visit_data.result;
 }
 
+/**
+ * Decl registered before is reached again, possibly by another worker, members of records reached through
+ * pointers alone are visited once they are reached directly.
+ */
+static void reach_decl(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
+                       CXCursor cursor) {
+    if (resect_context_await_build(context, &decl->builder)
+        && resect_is_struct(decl) && !resect_context_opaque_pointee(context)) {
+        resect_record_complete(visit_context, context, decl, cursor);
+    }
+}
+
 void resect_decl__create(resect_visit_context visit_context, resect_translation_context context, CXCursor cursor,
                          resect_decl_result *result) {
     result->decl = NULL;
@@ -581,17 +682,27 @@ void resect_decl__create(resect_visit_context visit_context, resect_translation_
 
     resect_decl registered_decl = resect_find_decl(context, decl_id);
     if (registered_decl != NULL) {
+        reach_decl(visit_context, context, registered_decl, cursor);
         result->decl = registered_decl;
         goto done;
     }
 
-    resect_decl decl = malloc(sizeof(struct P_resect_decl));
+    resect_decl decl = resect_allocate(sizeof(struct P_resect_decl));
     memset(decl, 0, sizeof(struct P_resect_decl));
 
     decl->id = resect_string_copy(decl_id);
     decl->kind = result->kind;
-
-    resect_register_decl(context, decl->id, decl);
+    resect_context_begin_build(context, &decl->builder);
+
+    registered_decl = resect_register_decl(context, decl->id, decl);
+    if (registered_decl != decl) {
+        // another worker got here first, nothing references this decl yet
+        resect_string_free(decl->id);
+        resect_deallocate(decl);
+        reach_decl(visit_context, context, registered_decl, cursor);
+        result->decl = registered_decl;
+        goto done;
+    }
     resect_register_decl_language(context, convert_language(clang_getCursorLanguage(cursor)));
 
     resect_decl_init_rest_from_cursor(decl, context, cursor);
@@ -649,6 +760,7 @@ void resect_decl__create(resect_visit_context visit_context, resect_translation_
     resect_decl_init_template_from_cursor(visit_context, decl, context, cursor);
 
     decl->type = resect_type_create(visit_context, context, clang_getCursorType(cursor));
+    resect_context_end_build(context, &decl->builder);
 
     result->decl = decl;
 
@@ -684,6 +796,14 @@ void resect_decl_free(resect_decl decl, resect_set deallocated) {
     }
     resect_type_set_free(decl->specialization_set, deallocated);
 
+    // both directions link registered decls only, which are owned by the context
+    if (decl->dependencies != NULL) {
+        resect_collection_free(decl->dependencies);
+    }
+    if (decl->dependents != NULL) {
+        resect_collection_free(decl->dependents);
+    }
+
     if (decl->template != NULL) {
         resect_decl_free(decl->template, deallocated);
     }
@@ -693,7 +813,7 @@ void resect_decl_free(resect_decl decl, resect_set deallocated) {
 
     resect_string_free(decl->source);
 
-    free(decl);
+    resect_deallocate(decl);
 }
 
 resect_decl_kind resect_decl_get_kind(resect_decl decl) { return decl->kind; }
@@ -704,8 +824,42 @@ const char *resect_decl_get_id(resect_decl decl) { return resect_string_to_c(dec
 
 resect_location resect_decl_get_location(resect_decl decl) { return decl->location; }
 
+int resect_decl_compare_location(const void *this, const void *that) {
+    resect_decl this_decl = *(resect_decl const *) this;
+    resect_decl that_decl = *(resect_decl const *) that;
+
+    int result = strcmp(resect_location_name(this_decl->location), resect_location_name(that_decl->location));
+    if (result != 0) {
+        return result;
+    }
+
+    if (this_decl->location->line != that_decl->location->line) {
+        return this_decl->location->line < that_decl->location->line ? -1 : 1;
+    }
+
+    if (this_decl->location->column != that_decl->location->column) {
+        return this_decl->location->column < that_decl->location->column ? -1 : 1;
+    }
+
+    // decls expanded from the same macro share location
+    return strcmp(resect_string_to_c(this_decl->id), resect_string_to_c(that_decl->id));
+}
+
 const char *resect_decl_get_name(resect_decl decl) { return resect_string_to_c(decl->name); }
 
+resect_string resect_decl_qualified_name(resect_decl decl) {
+    if (decl->owner != NULL) {
+        resect_string qualified_name = resect_decl_qualified_name(decl->owner);
+        resect_string_append_c(qualified_name, "::");
+        return resect_string_append_c(qualified_name, resect_string_to_c(decl->name));
+    }
+
+    if (resect_string_equal_c(decl->namespace, "")) {
+        return resect_string_copy(decl->name);
+    }
+    return resect_string_format("%s::%s", resect_string_to_c(decl->namespace), resect_string_to_c(decl->name));
+}
+
 resect_bool resect_decl_is_anonymous(resect_decl decl) { return resect_string_equal_c(decl->name, ""); }
 
 const char *resect_decl_get_namespace(resect_decl decl) { return resect_string_to_c(decl->namespace); }
@@ -726,6 +880,102 @@ resect_bool resect_decl_is_template(resect_decl decl) { return decl->is_template
 
 resect_collection resect_decl_template_parameters(resect_decl decl) { return decl->template_parameters; }
 
+void resect_decl_add_dependency(resect_decl decl, resect_decl dependency) {
+    if (decl->dependencies == NULL) {
+        decl->dependencies = resect_collection_create();
+    }
+    if (dependency->dependents == NULL) {
+        dependency->dependents = resect_collection_create();
+    }
+    resect_collection_add(decl->dependencies, dependency);
+    resect_collection_add(dependency->dependents, decl);
+}
+
+resect_collection resect_decl_dependencies(resect_decl decl) {
+    if (decl->dependencies == NULL) {
+        decl->dependencies = resect_collection_create();
+    }
+    return decl->dependencies;
+}
+
+resect_collection resect_decl_dependents(resect_decl decl) {
+    if (decl->dependents == NULL) {
+        decl->dependents = resect_collection_create();
+    }
+    return decl->dependents;
+}
+
+void resect_decl_unlink_dependencies(resect_decl decl) {
+    // collections might be handed out already, so they are emptied in place
+    if (decl->dependencies != NULL) {
+        clear_collection(decl->dependencies);
+    }
+    if (decl->dependents != NULL) {
+        clear_collection(decl->dependents);
+    }
+}
+
+static void add_decls_to_collection(resect_collection decls, resect_collection collection) {
+    resect_iterator iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(iter)) {
+        resect_collection_add(collection, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+}
+
+void resect_decl_collect_parts(resect_decl decl, resect_collection parts) {
+    add_decls_to_collection(decl->template_parameters, parts);
+    if (decl->data == NULL) {
+        return;
+    }
+
+    switch (decl->kind) {
+        case RESECT_DECL_KIND_STRUCT:
+        case RESECT_DECL_KIND_CLASS:
+        case RESECT_DECL_KIND_UNION:
+            add_decls_to_collection(resect_record_fields(decl), parts);
+            add_decls_to_collection(resect_record_methods(decl), parts);
+            break;
+        case RESECT_DECL_KIND_FUNCTION:
+            add_decls_to_collection(resect_function_parameters(decl), parts);
+            break;
+        case RESECT_DECL_KIND_METHOD:
+            add_decls_to_collection(resect_method_parameters(decl), parts);
+            break;
+        case RESECT_DECL_KIND_ENUM:
+            add_decls_to_collection(resect_enum_constants(decl), parts);
+            break;
+        default:;
+    }
+}
+
+bool resect_decl_refers_to_any(resect_decl decl, resect_set decls) {
+    if (decl->owner != NULL && resect_set_contains(decls, decl->owner)
+        || decl->template != NULL && resect_set_contains(decls, decl->template)) {
+        return true;
+    }
+
+    bool result = false;
+    if (decl->dependencies != NULL) {
+        resect_iterator dependency_iter = resect_collection_iterator(decl->dependencies);
+        while (!result && resect_iterator_next(dependency_iter)) {
+            result = resect_set_contains(decls, resect_iterator_value(dependency_iter));
+        }
+        resect_iterator_free(dependency_iter);
+    }
+
+    // specializations are located where their template is, but their arguments come from anywhere
+    resect_iterator argument_iter = resect_collection_iterator(decl->template_arguments);
+    while (!result && resect_iterator_next(argument_iter)) {
+        resect_template_argument argument = resect_iterator_value(argument_iter);
+        resect_decl argument_decl = argument->type != NULL ? resect_type_get_declaration(argument->type) : NULL;
+        result = argument_decl != NULL && resect_set_contains(decls, argument_decl);
+    }
+    resect_iterator_free(argument_iter);
+
+    return result;
+}
+
 resect_collection resect_decl_template_specializations(resect_decl decl) {
     if (decl->specializations == NULL) {
         decl->specializations = resect_collection_create();
@@ -742,6 +992,31 @@ resect_linkage_kind resect_decl_get_linkage(resect_decl decl) { return decl->lin
 
 resect_bool resect_decl_is_forward(resect_decl decl) { return decl->forward; }
 
+resect_symbol_status resect_decl_get_symbol_status(resect_decl decl) { return decl->symbol_status; }
+
+void resect_decl_update_symbol_status(resect_decl decl, resect_symbol_table symbols) {
+    switch (decl->kind) {
+        case RESECT_DECL_KIND_FUNCTION:
+        case RESECT_DECL_KIND_METHOD:
+        case RESECT_DECL_KIND_VARIABLE:
+            break;
+        default:
+            return;
+    }
+
+    if (decl->is_template || decl->linkage != RESECT_LINKAGE_KIND_EXTERNAL
+        || decl->mangled_name == NULL || resect_string_length(decl->mangled_name) == 0) {
+        return;
+    }
+
+    // symbol found in any of checked libraries stays available
+    if (resect_symbol_table_contains(symbols, resect_string_to_c(decl->mangled_name))) {
+        decl->symbol_status = RESECT_SYMBOL_STATUS_AVAILABLE;
+    } else if (decl->symbol_status == RESECT_SYMBOL_STATUS_UNKNOWN) {
+        decl->symbol_status = RESECT_SYMBOL_STATUS_MISSING;
+    }
+}
+
 void resect_decl_collection_free(resect_collection decls, resect_set deallocated) {
     resect_iterator iter = resect_collection_iterator(decls);
     while (resect_iterator_next(iter)) {
@@ -752,6 +1027,227 @@ void resect_decl_collection_free(resect_collection decls, resect_set deallocated
     resect_collection_free(decls);
 }
 
+/*
+ * DEPENDENCY ORDER
+ */
+struct P_resect_decl_group {
+    resect_collection decls;
+    resect_bool cyclic;
+};
+
+resect_collection resect_decl_group_declarations(resect_decl_group group) { return group->decls; }
+
+resect_bool resect_decl_group_is_cyclic(resect_decl_group group) { return group->cyclic; }
+
+void resect_decl_group_collection_free(resect_collection groups) {
+    resect_iterator iter = resect_collection_iterator(groups);
+    while (resect_iterator_next(iter)) {
+        resect_decl_group group = resect_iterator_value(iter);
+        resect_collection_free(group->decls);
+        resect_deallocate(group);
+    }
+    resect_iterator_free(iter);
+    resect_collection_free(groups);
+}
+
+typedef struct P_resect_scc_node {
+    unsigned int index;
+    unsigned int lowlink;
+    resect_bool on_stack;
+} *resect_scc_node;
+
+typedef struct P_resect_scc_frame {
+    resect_decl decl;
+    resect_iterator dependencies;
+} *resect_scc_frame;
+
+// nodes are keyed by decl id, so copies of the same decl are one node
+typedef struct P_resect_scc_data {
+    resect_table nodes;
+    resect_collection node_storage;
+    resect_collection stack;
+    // decl id -> exposed decl
+    resect_table exposed;
+    resect_collection groups;
+    unsigned int next_index;
+} *resect_scc_data;
+
+static resect_scc_node scc_enter(resect_scc_data data, resect_collection frames, resect_decl decl) {
+    resect_scc_node node = resect_allocate(sizeof(struct P_resect_scc_node));
+    node->index = data->next_index;
+    node->lowlink = data->next_index;
+    node->on_stack = resect_true;
+    ++data->next_index;
+
+    resect_table_put_if_absent(data->nodes, resect_decl_get_id(decl), node);
+    resect_collection_add(data->node_storage, node);
+    resect_collection_add(data->stack, decl);
+
+    resect_scc_frame frame = resect_allocate(sizeof(struct P_resect_scc_frame));
+    frame->decl = decl;
+    frame->dependencies = resect_collection_iterator(resect_decl_dependencies(decl));
+    resect_collection_add(frames, frame);
+    return node;
+}
+
+static resect_scc_node scc_node(resect_scc_data data, resect_decl decl) {
+    return resect_table_get(data->nodes, resect_decl_get_id(decl));
+}
+
+static resect_bool is_same_decl(resect_decl this, resect_decl that) {
+    if (this == NULL || that == NULL) {
+        return this == that ? resect_true : resect_false;
+    }
+    return resect_string_equal(this->id, that->id);
+}
+
+static void scc_emit_component(resect_scc_data data, resect_scc_node root_node) {
+    resect_collection component = resect_collection_create();
+    resect_scc_node member_node;
+    do {
+        resect_decl member = resect_collection_pop_last(data->stack);
+        member_node = scc_node(data, member);
+        member_node->on_stack = resect_false;
+        resect_collection_add(component, member);
+    } while (member_node != root_node);
+
+    resect_decl_group group = resect_allocate(sizeof(struct P_resect_decl_group));
+    group->decls = resect_collection_create();
+    // members of a record are part of its component, so size is checked before unexposed decls are dropped
+    group->cyclic = resect_collection_size(component) > 1 ? resect_true : resect_false;
+
+    // stack pops members in reverse order of discovery
+    while (resect_collection_size(component) > 0) {
+        resect_decl exposed_decl = resect_table_get(data->exposed, resect_decl_get_id(
+                resect_collection_pop_last(component)));
+        if (exposed_decl != NULL) {
+            resect_collection_add(group->decls, exposed_decl);
+        }
+    }
+    resect_collection_free(component);
+
+    if (resect_collection_size(group->decls) > 0) {
+        resect_collection_add(data->groups, group);
+    } else {
+        resect_collection_free(group->decls);
+        resect_deallocate(group);
+    }
+}
+
+static resect_bool field_refers_to_owner(resect_decl decl) {
+    if (decl->kind != RESECT_DECL_KIND_FIELD) {
+        return resect_false;
+    }
+
+    resect_type type = decl->type;
+    while (type != NULL) {
+        switch (resect_type_get_category(type)) {
+            case RESECT_TYPE_CATEGORY_POINTER:
+                type = resect_pointer_get_pointee_type(type);
+                break;
+            case RESECT_TYPE_CATEGORY_REFERENCE:
+                type = resect_reference_get_pointee_type(type);
+                break;
+            case RESECT_TYPE_CATEGORY_ARRAY:
+                type = resect_array_get_element_type(type);
+                break;
+            default:
+                return is_same_decl(resect_type_get_declaration(type), decl->owner);
+        }
+    }
+    return resect_false;
+}
+
+static void scc_visit(resect_scc_data data, resect_decl root) {
+    resect_collection frames = resect_collection_create();
+    scc_enter(data, frames, root);
+
+    while (resect_collection_size(frames) > 0) {
+        resect_scc_frame frame = resect_collection_peek_last(frames);
+        resect_scc_node node = scc_node(data, frame->decl);
+
+        if (resect_iterator_next(frame->dependencies)) {
+            resect_decl dependency = resect_iterator_value(frame->dependencies);
+            // members point back to their owners, which is only a real dependency for self-referencing fields
+            if (is_same_decl(dependency, frame->decl->owner) && !field_refers_to_owner(frame->decl)) {
+                continue;
+            }
+
+            resect_scc_node dependency_node = scc_node(data, dependency);
+            if (dependency_node == NULL) {
+                scc_enter(data, frames, dependency);
+            } else if (dependency_node->on_stack && dependency_node->index < node->lowlink) {
+                node->lowlink = dependency_node->index;
+            }
+            continue;
+        }
+
+        resect_collection_pop_last(frames);
+        if (node->lowlink == node->index) {
+            scc_emit_component(data, node);
+        }
+
+        resect_scc_frame parent_frame = resect_collection_peek_last(frames);
+        if (parent_frame != NULL) {
+            resect_scc_node parent_node = scc_node(data, parent_frame->decl);
+            if (node->lowlink < parent_node->lowlink) {
+                parent_node->lowlink = node->lowlink;
+            }
+        }
+
+        resect_iterator_free(frame->dependencies);
+        resect_deallocate(frame);
+    }
+
+    resect_collection_free(frames);
+}
+
+/**
+ * Tarjan's algorithm over decl dependencies, iterative to survive deep dependency chains.
+ * Components come out dependencies first, which is the order they can be declared in.
+ *
+ * @return collection of resect_decl_group
+ */
+resect_collection resect_decl_sort_by_dependencies(resect_collection decls) {
+    struct P_resect_scc_data data = {
+        .nodes = resect_table_create(),
+        .node_storage = resect_collection_create(),
+        .stack = resect_collection_create(),
+        .exposed = resect_table_create(),
+        .groups = resect_collection_create(),
+        .next_index = 0,
+    };
+
+    resect_iterator iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(iter)) {
+        resect_decl decl = resect_iterator_value(iter);
+        resect_table_put_if_absent(data.exposed, resect_decl_get_id(decl), decl);
+    }
+    resect_iterator_free(iter);
+
+    iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(iter)) {
+        resect_decl decl = resect_iterator_value(iter);
+        if (scc_node(&data, decl) == NULL) {
+            scc_visit(&data, decl);
+        }
+    }
+    resect_iterator_free(iter);
+
+    iter = resect_collection_iterator(data.node_storage);
+    while (resect_iterator_next(iter)) {
+        resect_deallocate(resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+
+    resect_collection_free(data.node_storage);
+    resect_table_free(data.nodes, NULL, NULL);
+    resect_collection_free(data.stack);
+    resect_table_free(data.exposed, NULL, NULL);
+
+    return data.groups;
+}
+
 /*
  * RECORD
  */
@@ -766,6 +1262,8 @@ typedef struct P_resect_record_data {
     resect_collection methods;
     resect_collection parents;
     resect_bool abstract;
+    // records reached only through pointers or references are left without members until reached directly
+    resect_bool members_visited;
 } *resect_record_data;
 
 resect_bool resect_is_struct(resect_decl decl) {
@@ -820,12 +1318,12 @@ void resect_field_data_free(void *data, resect_set deallocated) {
     if (!resect_set_add(deallocated, field)) {
         return;
     }
-    free(field);
+    resect_deallocate(field);
 }
 
 void resect_field_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
                        CXCursor cursor) {
-    resect_field_data data = malloc(sizeof(struct P_resect_field_data));
+    resect_field_data data = resect_allocate(sizeof(struct P_resect_field_data));
 
     data->offset = filter_valid_value(clang_Cursor_getOffsetOfField(cursor));
     data->bitfield = clang_Cursor_isBitField(cursor) != 0 ? resect_true : resect_false;
@@ -835,6 +1333,50 @@ void resect_field_init(resect_visit_context visit_context, resect_translation_co
     decl->data = data;
 }
 
+static unsigned int fill_record_layout(resect_decl decl, long long base_offset, resect_field_layout *layout,
+                                       unsigned int capacity, unsigned int count, resect_bool flatten_anonymous) {
+    resect_record_data record_data = decl->data;
+    resect_iterator iter = resect_collection_iterator(record_data->fields);
+    while (resect_iterator_next(iter)) {
+        resect_decl field = resect_iterator_value(iter);
+        resect_field_data field_data = field->data;
+        long long offset = base_offset + field_data->offset;
+
+        resect_decl member_decl = field->type != NULL ? resect_type_get_declaration(field->type) : NULL;
+        if (flatten_anonymous && resect_decl_is_anonymous(field)
+            && member_decl != NULL && resect_is_struct(member_decl) && member_decl->data != NULL) {
+            count = fill_record_layout(member_decl, offset, layout, capacity, count, flatten_anonymous);
+            continue;
+        }
+
+        if (count < capacity) {
+            resect_field_layout *entry = &layout[count];
+            entry->name = resect_string_to_c(field->name);
+            entry->offset = offset;
+            entry->type_kind = field->type != NULL ? resect_type_get_kind(field->type) : RESECT_TYPE_KIND_UNKNOWN;
+            entry->type_size = field->type != NULL ? resect_type_sizeof(field->type) : 0;
+            entry->width = field_data->bitfield ? field_data->width : entry->type_size;
+        }
+        ++count;
+    }
+    resect_iterator_free(iter);
+    return count;
+}
+
+/**
+ * Offsets, widths and sizes are in bits. Fills at most capacity entries.
+ *
+ * @return number of entries the whole layout takes, can be larger than capacity
+ */
+unsigned int resect_record_layout(resect_decl decl, resect_field_layout *layout, unsigned int capacity,
+                                  resect_bool flatten_anonymous) {
+    assert(resect_is_struct(decl));
+    if (decl->data == NULL) {
+        return 0;
+    }
+    return fill_record_layout(decl, 0, layout, capacity, 0, flatten_anonymous);
+}
+
 enum CXChildVisitResult resect_visit_record_child(CXCursor cursor, CXCursor parent, CXClientData data) {
     resect_decl_child_visit_data visit_data = data;
 
@@ -851,6 +1393,10 @@ enum CXChildVisitResult resect_visit_record_child(CXCursor cursor, CXCursor pare
         return CXChildVisit_Continue;
     }
 
+    if (resect_context_public_only(visit_data->translation_context) && !resect_is_public_member(cursor)) {
+        return CXChildVisit_Continue;
+    }
+
     resect_decl_result decl_result =
             resect_decl_create(visit_data->visit_context, visit_data->translation_context, cursor);
 
@@ -883,23 +1429,51 @@ void resect_record_data_free(void *data, resect_set deallocated) {
     resect_decl_collection_free(record_data->fields, deallocated);
     resect_type_collection_free(record_data->parents, deallocated);
 
-    free(data);
+    resect_deallocate(data);
 }
 
 void resect_record_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
                         CXCursor cursor) {
-    resect_record_data data = malloc(sizeof(struct P_resect_record_data));
+    resect_record_data data = resect_allocate(sizeof(struct P_resect_record_data));
     data->methods = resect_collection_create();
     data->fields = resect_collection_create();
     data->parents = resect_collection_create();
     data->abstract = convert_bool_from_uint(clang_CXXRecord_isAbstract(cursor));
+    data->members_visited = resect_false;
 
     decl->data_deallocator = resect_record_data_free;
     decl->data = data;
 
-    struct P_resect_decl_child_visit_data visit_data = {
-            .visit_context = visit_context, .translation_context = context, .parent = decl};
-    clang_visitChildren(cursor, resect_visit_record_child, &visit_data);
+    if (!resect_context_opaque_pointee(context)) {
+        resect_record_complete(visit_context, context, decl, cursor);
+    }
+}
+
+void resect_record_complete(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
+                            CXCursor cursor) {
+    resect_record_data data = decl->data;
+    if (data == NULL || data->members_visited) {
+        return;
+    }
+
+    resect_build_claim claim = resect_context_claim_build(context, &decl->builder);
+    // members might have been visited by another worker in the meantime
+    if (claim != RESECT_BUILD_BUSY && !data->members_visited) {
+        data->members_visited = resect_true;
+
+        struct P_resect_decl_child_visit_data visit_data = {
+                .visit_context = visit_context, .translation_context = context, .parent = decl};
+        clang_visitChildren(cursor, resect_visit_record_child, &visit_data);
+
+        if (decl->type != NULL) {
+            // the type was created opaque along with the decl, let it catch up
+            resect_type_create(visit_context, context, clang_getCursorType(cursor));
+        }
+    }
+
+    if (claim == RESECT_BUILD_CLAIMED) {
+        resect_context_end_build(context, &decl->builder);
+    }
 }
 
 /*
@@ -916,12 +1490,12 @@ void resect_typedef_data_free(void *data, resect_set deallocated) {
     }
     resect_typedef_data typedef_data = data;
     resect_type_free(typedef_data->aliased_type, deallocated);
-    free(typedef_data);
+    resect_deallocate(typedef_data);
 }
 
 void resect_typedef_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
                          CXCursor cursor) {
-    resect_typedef_data data = malloc(sizeof(struct P_resect_typedef_data));
+    resect_typedef_data data = resect_allocate(sizeof(struct P_resect_typedef_data));
 
     CXType canonical_type = clang_getCanonicalType(clang_getTypedefDeclUnderlyingType(cursor));
 
@@ -1083,12 +1657,12 @@ void resect_function_data_free(void *data, resect_set deallocated) {
     resect_function_data function = data;
     resect_decl_collection_free(function->parameters, deallocated);
     resect_type_free(function->result_type, deallocated);
-    free(function);
+    resect_deallocate(function);
 }
 
 resect_function_data resect_function_data_create(resect_visit_context visit_context, resect_translation_context context,
                                                  CXCursor cursor) {
-    resect_function_data data = malloc(sizeof(struct P_resect_function_data));
+    resect_function_data data = resect_allocate(sizeof(struct P_resect_function_data));
 
     CXType functionType = clang_getCursorType(cursor);
     data->parameters = resect_collection_create();
@@ -1128,7 +1702,7 @@ void resect_enum_constant_free(void *data, resect_set deallocated) {
         return;
     }
 
-    free(data);
+    resect_deallocate(data);
 }
 
 long long resect_enum_constant_value(resect_decl decl) {
@@ -1151,7 +1725,7 @@ resect_bool resect_enum_constant_is_unsigned(resect_decl decl) {
 
 void resect_enum_constant_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
                                CXCursor cursor) {
-    resect_enum_constant_data data = malloc(sizeof(struct P_resect_enum_constant_data));
+    resect_enum_constant_data data = resect_allocate(sizeof(struct P_resect_enum_constant_data));
 
     CXType enum_value_type = clang_getEnumDeclIntegerType(clang_getCursorSemanticParent(cursor));
 
@@ -1224,12 +1798,12 @@ void resect_enum_data_free(void *data, resect_set deallocated) {
     resect_enum_data enum_data = data;
     resect_type_free(enum_data->type, deallocated);
     resect_decl_collection_free(enum_data->constants, deallocated);
-    free(enum_data);
+    resect_deallocate(enum_data);
 }
 
 void resect_enum_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
                       CXCursor cursor) {
-    resect_enum_data data = malloc(sizeof(struct P_resect_enum_data));
+    resect_enum_data data = resect_allocate(sizeof(struct P_resect_enum_data));
     data->constants = resect_collection_create();
     CXType enum_type = clang_getEnumDeclIntegerType(cursor);
 
@@ -1297,43 +1871,55 @@ void resect_variable_data_free(void *data, resect_set deallocated) {
     resect_variable_data var_data = data;
     resect_string_free(var_data->string_value);
 
-    free(data);
+    resect_deallocate(data);
 }
 
-void resect_variable_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
-                          CXCursor cursor) {
-    CXEvalResult value = clang_Cursor_Evaluate(cursor);
-    resect_variable_data data = malloc(sizeof(struct P_resect_variable_data));
-
-    data->storage_class = convert_storage_class(clang_Cursor_getStorageClass(cursor));
-    data->string_value = resect_string_from_c("");
-
+static resect_variable_kind convert_eval_result(CXEvalResult value, resect_string string_value,
+                                                long long *int_value, double *float_value) {
     switch (clang_EvalResult_getKind(value)) {
         case CXEval_Int:
-            data->kind = RESECT_VARIABLE_TYPE_INT;
-            data->int_value = clang_EvalResult_getAsLongLong(value);
-            break;
+            *int_value = clang_EvalResult_getAsLongLong(value);
+            return RESECT_VARIABLE_TYPE_INT;
         case CXEval_Float:
-            data->kind = RESECT_VARIABLE_TYPE_FLOAT;
-            data->float_value = clang_EvalResult_getAsDouble(value);
-            break;
+            *float_value = clang_EvalResult_getAsDouble(value);
+            return RESECT_VARIABLE_TYPE_FLOAT;
         case CXEval_CFStr:
         case CXEval_ObjCStrLiteral:
         case CXEval_StrLiteral:
-            data->kind = RESECT_VARIABLE_TYPE_STRING;
-            resect_string_update_c(data->string_value, clang_EvalResult_getAsStr(value));
-            break;
+            resect_string_update_c(string_value, clang_EvalResult_getAsStr(value));
+            return RESECT_VARIABLE_TYPE_STRING;
         case CXEval_Other:
-            data->kind = RESECT_VARIABLE_TYPE_OTHER;
-            resect_string_update_c(data->string_value, clang_EvalResult_getAsStr(value));
+            resect_string_update_c(string_value, clang_EvalResult_getAsStr(value));
+            return RESECT_VARIABLE_TYPE_OTHER;
         default:
-            data->kind = RESECT_VARIABLE_TYPE_UNKNOWN;
+            return RESECT_VARIABLE_TYPE_UNKNOWN;
     }
+}
+
+// variables without initializer have nothing to evaluate, so extern and uninitialized ones are not worth a try
+static bool is_evaluable_variable(resect_translation_context context, CXCursor cursor) {
+    return !resect_context_skip_evaluation(context)
+           && !clang_Cursor_isNull(clang_Cursor_getVarDeclInitializer(cursor))
+           && clang_Cursor_getStorageClass(cursor) != CX_SC_Extern;
+}
+
+void resect_variable_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
+                          CXCursor cursor) {
+    CXEvalResult value = is_evaluable_variable(context, cursor) ? clang_Cursor_Evaluate(cursor) : NULL;
+    resect_variable_data data = resect_allocate(sizeof(struct P_resect_variable_data));
+
+    data->storage_class = convert_storage_class(clang_Cursor_getStorageClass(cursor));
+    data->string_value = resect_string_from_c("");
+    data->int_value = 0;
+    data->float_value = 0;
+    data->kind = convert_eval_result(value, data->string_value, &data->int_value, &data->float_value);
 
     decl->data = data;
     decl->data_deallocator = resect_variable_data_free;
 
-    clang_EvalResult_dispose(value);
+    if (value != NULL) {
+        clang_EvalResult_dispose(value);
+    }
 }
 
 /*
@@ -1341,6 +1927,13 @@ void resect_variable_init(resect_visit_context visit_context, resect_translation
  */
 typedef struct P_resect_macro_data {
     resect_bool is_function_like;
+    // replacement list tokens separated by spaces
+    resect_string body;
+
+    resect_variable_kind value_kind;
+    resect_string string_value;
+    long long int_value;
+    double float_value;
 } *resect_macro_data;
 
 resect_bool resect_macro_is_function_like(resect_decl decl) {
@@ -1349,22 +1942,175 @@ resect_bool resect_macro_is_function_like(resect_decl decl) {
     return data->is_function_like;
 }
 
+resect_variable_kind resect_macro_get_value_kind(resect_decl decl) {
+    assert(decl->kind == RESECT_DECL_KIND_MACRO);
+    resect_macro_data data = decl->data;
+    return data->value_kind;
+}
+
+long long resect_macro_get_value_as_int(resect_decl decl) {
+    assert(decl->kind == RESECT_DECL_KIND_MACRO);
+    resect_macro_data data = decl->data;
+    return data->int_value;
+}
+
+double resect_macro_get_value_as_float(resect_decl decl) {
+    assert(decl->kind == RESECT_DECL_KIND_MACRO);
+    resect_macro_data data = decl->data;
+    return data->float_value;
+}
+
+const char *resect_macro_get_value_as_string(resect_decl decl) {
+    assert(decl->kind == RESECT_DECL_KIND_MACRO);
+    resect_macro_data data = decl->data;
+    return resect_string_to_c(data->string_value);
+}
+
+const char *resect_macro_body(resect_decl decl) {
+    assert(decl->kind == RESECT_DECL_KIND_MACRO);
+    resect_macro_data data = decl->data;
+    return resect_string_to_c(data->body);
+}
+
+void resect_macro_evaluate(resect_decl decl, CXEvalResult value) {
+    assert(decl->kind == RESECT_DECL_KIND_MACRO);
+    resect_macro_data data = decl->data;
+    data->value_kind = convert_eval_result(value, data->string_value, &data->int_value, &data->float_value);
+}
+
 void resect_macro_data_free(void *data, resect_set deallocated) {
     if (data == NULL || !resect_set_add(deallocated, data)) {
         return;
     }
 
-    free(data);
+    resect_macro_data macro_data = data;
+    resect_string_free(macro_data->body);
+    resect_string_free(macro_data->string_value);
+
+    resect_deallocate(data);
+}
+
+static bool is_expression_keyword(const char *spelling) {
+    static const char *const expression_keywords[] = {
+            "sizeof", "alignof", "_Alignof", "__alignof", "__alignof__",
+            "true", "false", "nullptr",
+            "static_cast", "const_cast", "reinterpret_cast",
+            "const", "volatile", "signed", "unsigned", "__signed__", "__unsigned__",
+            "void", "bool", "_Bool", "char", "char8_t", "char16_t", "char32_t", "wchar_t",
+            "short", "int", "long", "float", "double"
+    };
+
+    for (unsigned int i = 0; i < sizeof(expression_keywords) / sizeof(expression_keywords[0]); ++i) {
+        if (strcmp(spelling, expression_keywords[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns empty string if macro body cannot form an expression, because all bodies are evaluated together
+ * in a single unit and one declaration-like body (`extern "C" {`, `__attribute__((...))`, `;`) breaks all of them.
+ */
+static resect_string extract_macro_body(CXCursor cursor) {
+    resect_string body = resect_string_from_c("");
+    bool expression = true;
+    int paren_depth = 0;
+    int bracket_depth = 0;
+
+    CXTranslationUnit unit = clang_Cursor_getTranslationUnit(cursor);
+    CXSourceRange extent = clang_getCursorExtent(cursor);
+    unsigned int end_offset = 0;
+    clang_getSpellingLocation(clang_getRangeEnd(extent), NULL, NULL, NULL, &end_offset);
+
+    CXToken *tokens = NULL;
+    unsigned int token_count = 0;
+    clang_tokenize(unit, extent, &tokens, &token_count);
+
+    // first token is the macro name
+    for (unsigned int i = 1; i < token_count; ++i) {
+        unsigned int offset = 0;
+        clang_getSpellingLocation(clang_getTokenLocation(unit, tokens[i]), NULL, NULL, NULL, &offset);
+        if (offset >= end_offset) {
+            // some libclang versions tokenize one token past the extent
+            break;
+        }
+
+        CXString spelling = clang_getTokenSpelling(unit, tokens[i]);
+        const char *token = clang_getCString(spelling);
+        switch (clang_getTokenKind(tokens[i])) {
+            case CXToken_Keyword:
+                expression = is_expression_keyword(token);
+                break;
+            case CXToken_Punctuation:
+                if (strcmp(token, "(") == 0) {
+                    ++paren_depth;
+                } else if (strcmp(token, ")") == 0) {
+                    expression = --paren_depth >= 0;
+                } else if (strcmp(token, "[") == 0) {
+                    ++bracket_depth;
+                } else if (strcmp(token, "]") == 0) {
+                    expression = --bracket_depth >= 0;
+                } else if (strcmp(token, "{") == 0 || strcmp(token, "}") == 0 || strcmp(token, ";") == 0
+                           || strcmp(token, "#") == 0 || strcmp(token, "##") == 0) {
+                    expression = false;
+                }
+                break;
+            case CXToken_Identifier:
+                // attributes and declspecs are identifiers in some libclang versions
+                expression = strncmp(token, "__attribute", 11) != 0 && strcmp(token, "__declspec") != 0
+                             && strncmp(token, "__asm", 5) != 0;
+                break;
+            default:
+                break;
+        }
+
+        if (i > 1) {
+            resect_string_append_c(body, " ");
+        }
+        resect_string_append_c(body, token);
+        clang_disposeString(spelling);
+
+        if (!expression) {
+            break;
+        }
+    }
+
+    if (tokens != NULL) {
+        clang_disposeTokens(unit, tokens, token_count);
+    }
+
+    if (!expression || paren_depth != 0 || bracket_depth != 0) {
+        resect_string_free(body);
+        return resect_string_from_c("");
+    }
+
+    return body;
 }
 
 void resect_macro_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
                        CXCursor cursor) {
-    resect_macro_data data = malloc(sizeof(struct P_resect_macro_data));
+    resect_macro_data data = resect_allocate(sizeof(struct P_resect_macro_data));
 
     data->is_function_like = clang_Cursor_isMacroFunctionLike(cursor) != 0 ? resect_true : resect_false;
+    data->value_kind = RESECT_VARIABLE_TYPE_UNKNOWN;
+    data->string_value = resect_string_from_c("");
+    data->int_value = 0;
+    data->float_value = 0;
+
+    // only object-like macros can be evaluated, function-like ones need arguments
+    if (data->is_function_like || clang_Cursor_isMacroBuiltin(cursor) || !resect_context_evaluate_macros(context)) {
+        data->body = resect_string_from_c("");
+    } else {
+        data->body = extract_macro_body(cursor);
+    }
 
     decl->data_deallocator = resect_macro_data_free;
     decl->data = data;
+
+    if (resect_string_length(data->body) > 0) {
+        resect_context_add_macro(context, decl);
+    }
 }
 
 /*
@@ -1441,12 +2187,12 @@ void resect_method_data_free(void *data, resect_set deallocated) {
     resect_method_data method_data = data;
     resect_function_data_free(method_data->function_data, deallocated);
 
-    free(data);
+    resect_deallocate(data);
 }
 
 void resect_method_init(resect_visit_context visit_context, resect_translation_context context, resect_decl decl,
                         CXCursor cursor) {
-    resect_method_data data = malloc(sizeof(struct P_resect_method_data));
+    resect_method_data data = resect_allocate(sizeof(struct P_resect_method_data));
 
     data->function_data = resect_function_data_create(visit_context, context, cursor);
 
@@ -1475,7 +2221,7 @@ void resect_template_parameter_data_free(void *data, resect_set deallocated) {
     if (data == NULL || !resect_set_add(deallocated, data)) {
         return;
     }
-    free(data);
+    resect_deallocate(data);
 }
 
 resect_template_parameter_kind convert_template_parameter_kind(enum CXCursorKind kind) {
@@ -1493,7 +2239,7 @@ resect_template_parameter_kind convert_template_parameter_kind(enum CXCursorKind
 
 void resect_template_parameter_init(resect_visit_context visit_context, resect_translation_context context,
                                     resect_decl decl, CXCursor cursor) {
-    resect_template_parameter_data data = malloc(sizeof(struct P_resect_template_parameter_data));
+    resect_template_parameter_data data = resect_allocate(sizeof(struct P_resect_template_parameter_data));
 
     data->kind = convert_template_parameter_kind(clang_getCursorKind(cursor));
 
@@ -1508,3 +2254,391 @@ resect_template_parameter_kind resect_template_parameter_get_kind(resect_decl de
     resect_template_parameter_data data = decl->data;
     return data->kind;
 }
+
+/*
+ * SERIALIZATION
+ */
+resect_decl resect_decl_allocate() {
+    resect_decl decl = resect_allocate(sizeof(struct P_resect_decl));
+    memset(decl, 0, sizeof(struct P_resect_decl));
+    return decl;
+}
+
+// function data layout: variadic, storage class, parameters, parameter count, calling convention, result type, inlined
+#define FUNCTION_DATA_SIZE (7)
+
+static void resect_function_data_serialize(resect_function_data data, resect_writer writer, uint32_t *values) {
+    values[0] = data->variadic;
+    values[1] = data->storage_class;
+    values[2] = resect_writer_decl_collection(writer, data->parameters);
+    values[3] = resect_collection_size(data->parameters);
+    values[4] = data->calling_convention;
+    values[5] = resect_writer_type(writer, data->result_type);
+    values[6] = data->inlined;
+}
+
+static resect_function_data resect_function_data_deserialize(resect_reader reader, uint32_t offset) {
+    resect_function_data data = resect_allocate(sizeof(struct P_resect_function_data));
+    data->variadic = resect_reader_value(reader, offset);
+    data->storage_class = resect_reader_value(reader, offset + 1);
+    data->parameters = resect_collection_create();
+    resect_reader_decl_collection(reader,
+                                  resect_reader_value(reader, offset + 2),
+                                  resect_reader_value(reader, offset + 3),
+                                  data->parameters);
+    data->calling_convention = resect_reader_value(reader, offset + 4);
+    data->result_type = resect_reader_type(reader, resect_reader_value(reader, offset + 5));
+    data->inlined = resect_reader_value(reader, offset + 6);
+    return data;
+}
+
+static uint32_t resect_decl_data_serialize(resect_decl decl, resect_writer writer) {
+    if (decl->data == NULL) {
+        return RESECT_NO_REF;
+    }
+
+    uint32_t values[FUNCTION_DATA_SIZE + 4];
+    uint32_t count = 0;
+
+    switch (decl->kind) {
+        case RESECT_DECL_KIND_STRUCT:
+        case RESECT_DECL_KIND_CLASS:
+        case RESECT_DECL_KIND_UNION: {
+            resect_record_data data = decl->data;
+            values[0] = resect_writer_decl_collection(writer, data->fields);
+            values[1] = resect_collection_size(data->fields);
+            values[2] = resect_writer_decl_collection(writer, data->methods);
+            values[3] = resect_collection_size(data->methods);
+            values[4] = resect_writer_type_collection(writer, data->parents);
+            values[5] = resect_collection_size(data->parents);
+            values[6] = data->abstract;
+            count = 7;
+        }
+        break;
+        case RESECT_DECL_KIND_FIELD: {
+            resect_field_data data = decl->data;
+            values[0] = data->bitfield;
+            values[1] = RESECT_LOW_BITS(data->width);
+            values[2] = RESECT_HIGH_BITS(data->width);
+            values[3] = RESECT_LOW_BITS(data->offset);
+            values[4] = RESECT_HIGH_BITS(data->offset);
+            count = 5;
+        }
+        break;
+        case RESECT_DECL_KIND_TYPEDEF: {
+            resect_typedef_data data = decl->data;
+            values[0] = resect_writer_type(writer, data->aliased_type);
+            count = 1;
+        }
+        break;
+        case RESECT_DECL_KIND_FUNCTION:
+            resect_function_data_serialize(decl->data, writer, values);
+            count = FUNCTION_DATA_SIZE;
+            break;
+        case RESECT_DECL_KIND_METHOD: {
+            resect_method_data data = decl->data;
+            resect_function_data_serialize(data->function_data, writer, values);
+            values[FUNCTION_DATA_SIZE] = data->pure_virtual;
+            values[FUNCTION_DATA_SIZE + 1] = data->virtual;
+            values[FUNCTION_DATA_SIZE + 2] = data->non_mutating;
+            values[FUNCTION_DATA_SIZE + 3] = data->deleted;
+            count = FUNCTION_DATA_SIZE + 4;
+        }
+        break;
+        case RESECT_DECL_KIND_ENUM: {
+            resect_enum_data data = decl->data;
+            values[0] = resect_writer_decl_collection(writer, data->constants);
+            values[1] = resect_collection_size(data->constants);
+            values[2] = resect_writer_type(writer, data->type);
+            count = 3;
+        }
+        break;
+        case RESECT_DECL_KIND_ENUM_CONSTANT: {
+            resect_enum_constant_data data = decl->data;
+            values[0] = data->is_unsigned;
+            values[1] = RESECT_LOW_BITS(data->unsigned_value);
+            values[2] = RESECT_HIGH_BITS(data->unsigned_value);
+            count = 3;
+        }
+        break;
+        case RESECT_DECL_KIND_VARIABLE: {
+            resect_variable_data data = decl->data;
+            uint64_t float_bits;
+            memcpy(&float_bits, &data->float_value, sizeof(float_bits));
+            values[0] = data->kind;
+            values[1] = resect_writer_string(writer, data->string_value);
+            values[2] = RESECT_LOW_BITS(data->int_value);
+            values[3] = RESECT_HIGH_BITS(data->int_value);
+            values[4] = RESECT_LOW_BITS(float_bits);
+            values[5] = RESECT_HIGH_BITS(float_bits);
+            values[6] = data->storage_class;
+            count = 7;
+        }
+        break;
+        case RESECT_DECL_KIND_MACRO: {
+            resect_macro_data data = decl->data;
+            uint64_t float_bits;
+            memcpy(&float_bits, &data->float_value, sizeof(float_bits));
+            values[0] = data->is_function_like;
+            values[1] = data->value_kind;
+            values[2] = resect_writer_string(writer, data->string_value);
+            values[3] = RESECT_LOW_BITS(data->int_value);
+            values[4] = RESECT_HIGH_BITS(data->int_value);
+            values[5] = RESECT_LOW_BITS(float_bits);
+            values[6] = RESECT_HIGH_BITS(float_bits);
+            count = 7;
+        }
+        break;
+        case RESECT_DECL_KIND_TEMPLATE_PARAMETER: {
+            resect_template_parameter_data data = decl->data;
+            values[0] = data->kind;
+            count = 1;
+        }
+        break;
+        default:
+            return RESECT_NO_REF;
+    }
+
+    return resect_writer_block(writer, values, count);
+}
+
+static void resect_decl_data_deserialize(resect_decl decl, resect_reader reader, uint32_t offset) {
+    switch (decl->kind) {
+        case RESECT_DECL_KIND_STRUCT:
+        case RESECT_DECL_KIND_CLASS:
+        case RESECT_DECL_KIND_UNION: {
+            resect_record_data data = resect_allocate(sizeof(struct P_resect_record_data));
+            data->fields = resect_collection_create();
+            resect_reader_decl_collection(reader,
+                                          resect_reader_value(reader, offset),
+                                          resect_reader_value(reader, offset + 1),
+                                          data->fields);
+            data->methods = resect_collection_create();
+            resect_reader_decl_collection(reader,
+                                          resect_reader_value(reader, offset + 2),
+                                          resect_reader_value(reader, offset + 3),
+                                          data->methods);
+            data->parents = resect_collection_create();
+            resect_reader_type_collection(reader,
+                                          resect_reader_value(reader, offset + 4),
+                                          resect_reader_value(reader, offset + 5),
+                                          data->parents);
+            data->abstract = resect_reader_value(reader, offset + 6);
+            data->members_visited = resect_true;
+
+            decl->data_deallocator = resect_record_data_free;
+            decl->data = data;
+        }
+        break;
+        case RESECT_DECL_KIND_FIELD: {
+            resect_field_data data = resect_allocate(sizeof(struct P_resect_field_data));
+            data->bitfield = resect_reader_value(reader, offset);
+            data->width = (long long) RESECT_JOIN_BITS(resect_reader_value(reader, offset + 1),
+                                                       resect_reader_value(reader, offset + 2));
+            data->offset = (long long) RESECT_JOIN_BITS(resect_reader_value(reader, offset + 3),
+                                                        resect_reader_value(reader, offset + 4));
+
+            decl->data_deallocator = resect_field_data_free;
+            decl->data = data;
+        }
+        break;
+        case RESECT_DECL_KIND_TYPEDEF: {
+            resect_typedef_data data = resect_allocate(sizeof(struct P_resect_typedef_data));
+            data->aliased_type = resect_reader_type(reader, resect_reader_value(reader, offset));
+
+            decl->data_deallocator = resect_typedef_data_free;
+            decl->data = data;
+        }
+        break;
+        case RESECT_DECL_KIND_FUNCTION:
+            decl->data_deallocator = resect_function_data_free;
+            decl->data = resect_function_data_deserialize(reader, offset);
+            break;
+        case RESECT_DECL_KIND_METHOD: {
+            resect_method_data data = resect_allocate(sizeof(struct P_resect_method_data));
+            data->function_data = resect_function_data_deserialize(reader, offset);
+            data->pure_virtual = resect_reader_value(reader, offset + FUNCTION_DATA_SIZE);
+            data->virtual = resect_reader_value(reader, offset + FUNCTION_DATA_SIZE + 1);
+            data->non_mutating = resect_reader_value(reader, offset + FUNCTION_DATA_SIZE + 2);
+            data->deleted = resect_reader_value(reader, offset + FUNCTION_DATA_SIZE + 3);
+
+            decl->data_deallocator = resect_method_data_free;
+            decl->data = data;
+        }
+        break;
+        case RESECT_DECL_KIND_ENUM: {
+            resect_enum_data data = resect_allocate(sizeof(struct P_resect_enum_data));
+            data->constants = resect_collection_create();
+            resect_reader_decl_collection(reader,
+                                          resect_reader_value(reader, offset),
+                                          resect_reader_value(reader, offset + 1),
+                                          data->constants);
+            data->type = resect_reader_type(reader, resect_reader_value(reader, offset + 2));
+
+            decl->data_deallocator = resect_enum_data_free;
+            decl->data = data;
+        }
+        break;
+        case RESECT_DECL_KIND_ENUM_CONSTANT: {
+            resect_enum_constant_data data = resect_allocate(sizeof(struct P_resect_enum_constant_data));
+            data->is_unsigned = resect_reader_value(reader, offset);
+            data->unsigned_value = RESECT_JOIN_BITS(resect_reader_value(reader, offset + 1),
+                                                    resect_reader_value(reader, offset + 2));
+            data->value = (long long) data->unsigned_value;
+
+            decl->data_deallocator = resect_enum_constant_free;
+            decl->data = data;
+        }
+        break;
+        case RESECT_DECL_KIND_VARIABLE: {
+            resect_variable_data data = resect_allocate(sizeof(struct P_resect_variable_data));
+            uint64_t float_bits = RESECT_JOIN_BITS(resect_reader_value(reader, offset + 4),
+                                                   resect_reader_value(reader, offset + 5));
+            data->kind = resect_reader_value(reader, offset);
+            data->string_value = resect_reader_string(reader, resect_reader_value(reader, offset + 1));
+            data->int_value = (long long) RESECT_JOIN_BITS(resect_reader_value(reader, offset + 2),
+                                                           resect_reader_value(reader, offset + 3));
+            memcpy(&data->float_value, &float_bits, sizeof(float_bits));
+            data->storage_class = resect_reader_value(reader, offset + 6);
+
+            decl->data_deallocator = resect_variable_data_free;
+            decl->data = data;
+        }
+        break;
+        case RESECT_DECL_KIND_MACRO: {
+            resect_macro_data data = resect_allocate(sizeof(struct P_resect_macro_data));
+            uint64_t float_bits = RESECT_JOIN_BITS(resect_reader_value(reader, offset + 5),
+                                                   resect_reader_value(reader, offset + 6));
+            data->is_function_like = resect_reader_value(reader, offset);
+            data->body = resect_string_from_c("");
+            data->value_kind = resect_reader_value(reader, offset + 1);
+            data->string_value = resect_reader_string(reader, resect_reader_value(reader, offset + 2));
+            data->int_value = (long long) RESECT_JOIN_BITS(resect_reader_value(reader, offset + 3),
+                                                           resect_reader_value(reader, offset + 4));
+            memcpy(&data->float_value, &float_bits, sizeof(float_bits));
+
+            decl->data_deallocator = resect_macro_data_free;
+            decl->data = data;
+        }
+        break;
+        case RESECT_DECL_KIND_TEMPLATE_PARAMETER: {
+            resect_template_parameter_data data = resect_allocate(sizeof(struct P_resect_template_parameter_data));
+            data->kind = resect_reader_value(reader, offset);
+
+            decl->data_deallocator = resect_template_parameter_data_free;
+            decl->data = data;
+        }
+        break;
+        default:;
+    }
+}
+
+void resect_decl_serialize(resect_decl decl, resect_writer writer, uint32_t *record) {
+    record[RESECT_DECL_RECORD_KIND] = decl->kind;
+    record[RESECT_DECL_RECORD_ID] = resect_writer_string(writer, decl->id);
+    record[RESECT_DECL_RECORD_NAME] = resect_writer_string(writer, decl->name);
+    record[RESECT_DECL_RECORD_NAMESPACE] = resect_writer_string(writer, decl->namespace);
+    record[RESECT_DECL_RECORD_MANGLED_NAME] = resect_writer_string(writer, decl->mangled_name);
+    record[RESECT_DECL_RECORD_COMMENT] = resect_writer_string(writer, decl->comment);
+    record[RESECT_DECL_RECORD_SOURCE] = resect_writer_string(writer, decl->source);
+    record[RESECT_DECL_RECORD_LOCATION_NAME] = resect_writer_string(writer, decl->location->name);
+    record[RESECT_DECL_RECORD_LOCATION_LINE] = decl->location->line;
+    record[RESECT_DECL_RECORD_LOCATION_COLUMN] = decl->location->column;
+    record[RESECT_DECL_RECORD_ACCESS] = decl->access;
+    record[RESECT_DECL_RECORD_LINKAGE] = decl->linkage;
+    record[RESECT_DECL_RECORD_FLAGS] = (decl->is_template ? RESECT_DECL_RECORD_FLAG_TEMPLATE : 0)
+                                       | (decl->partial ? RESECT_DECL_RECORD_FLAG_PARTIAL : 0)
+                                       | (decl->forward ? RESECT_DECL_RECORD_FLAG_FORWARD : 0);
+    record[RESECT_DECL_RECORD_SYMBOL_STATUS] = decl->symbol_status;
+    record[RESECT_DECL_RECORD_TEMPLATE] = resect_writer_decl(writer, decl->template);
+    record[RESECT_DECL_RECORD_OWNER] = resect_writer_decl(writer, decl->owner);
+    record[RESECT_DECL_RECORD_TYPE] = resect_writer_type(writer, decl->type);
+
+    record[RESECT_DECL_RECORD_TEMPLATE_PARAMETERS] =
+            resect_writer_decl_collection(writer, decl->template_parameters);
+    record[RESECT_DECL_RECORD_TEMPLATE_PARAMETER_COUNT] = resect_collection_size(decl->template_parameters);
+
+    record[RESECT_DECL_RECORD_TEMPLATE_ARGUMENTS] =
+            resect_template_argument_collection_serialize(decl->template_arguments, writer);
+    record[RESECT_DECL_RECORD_TEMPLATE_ARGUMENT_COUNT] = resect_collection_size(decl->template_arguments);
+
+    resect_collection specializations = resect_collection_create();
+    resect_set_add_to_collection(decl->specialization_set, specializations);
+    record[RESECT_DECL_RECORD_SPECIALIZATIONS] = resect_writer_type_collection(writer, specializations);
+    record[RESECT_DECL_RECORD_SPECIALIZATION_COUNT] = resect_collection_size(specializations);
+    resect_collection_free(specializations);
+
+    record[RESECT_DECL_RECORD_DEPENDENCIES] =
+            resect_writer_decl_collection(writer, resect_decl_dependencies(decl));
+    record[RESECT_DECL_RECORD_DEPENDENCY_COUNT] = resect_collection_size(resect_decl_dependencies(decl));
+    record[RESECT_DECL_RECORD_DEPENDENTS] = resect_writer_decl_collection(writer, resect_decl_dependents(decl));
+    record[RESECT_DECL_RECORD_DEPENDENT_COUNT] = resect_collection_size(resect_decl_dependents(decl));
+
+    record[RESECT_DECL_RECORD_DATA] = resect_decl_data_serialize(decl, writer);
+}
+
+void resect_decl_deserialize(resect_decl decl, resect_reader reader, const uint32_t *record) {
+    decl->kind = record[RESECT_DECL_RECORD_KIND];
+    decl->id = resect_reader_string(reader, record[RESECT_DECL_RECORD_ID]);
+    decl->name = resect_reader_string(reader, record[RESECT_DECL_RECORD_NAME]);
+    decl->namespace = resect_reader_string(reader, record[RESECT_DECL_RECORD_NAMESPACE]);
+    decl->mangled_name = resect_reader_string(reader, record[RESECT_DECL_RECORD_MANGLED_NAME]);
+    decl->comment = resect_reader_string(reader, record[RESECT_DECL_RECORD_COMMENT]);
+    decl->source = resect_reader_string(reader, record[RESECT_DECL_RECORD_SOURCE]);
+
+    decl->location = resect_allocate(sizeof(struct P_resect_location));
+    decl->location->name = resect_reader_string(reader, record[RESECT_DECL_RECORD_LOCATION_NAME]);
+    decl->location->line = record[RESECT_DECL_RECORD_LOCATION_LINE];
+    decl->location->column = record[RESECT_DECL_RECORD_LOCATION_COLUMN];
+
+    decl->access = record[RESECT_DECL_RECORD_ACCESS];
+    decl->linkage = record[RESECT_DECL_RECORD_LINKAGE];
+    decl->is_template = convert_bool_from_uint(record[RESECT_DECL_RECORD_FLAGS] & RESECT_DECL_RECORD_FLAG_TEMPLATE);
+    decl->partial = convert_bool_from_uint(record[RESECT_DECL_RECORD_FLAGS] & RESECT_DECL_RECORD_FLAG_PARTIAL);
+    decl->forward = convert_bool_from_uint(record[RESECT_DECL_RECORD_FLAGS] & RESECT_DECL_RECORD_FLAG_FORWARD);
+    decl->symbol_status = record[RESECT_DECL_RECORD_SYMBOL_STATUS];
+
+    decl->template = resect_reader_decl(reader, record[RESECT_DECL_RECORD_TEMPLATE]);
+    decl->owner = resect_reader_decl(reader, record[RESECT_DECL_RECORD_OWNER]);
+    decl->type = resect_reader_type(reader, record[RESECT_DECL_RECORD_TYPE]);
+
+    decl->template_parameters = resect_collection_create();
+    resect_reader_decl_collection(reader,
+                                  record[RESECT_DECL_RECORD_TEMPLATE_PARAMETERS],
+                                  record[RESECT_DECL_RECORD_TEMPLATE_PARAMETER_COUNT],
+                                  decl->template_parameters);
+
+    decl->template_arguments = resect_collection_create();
+    resect_template_argument_collection_deserialize(decl->template_arguments, reader,
+                                                    record[RESECT_DECL_RECORD_TEMPLATE_ARGUMENTS],
+                                                    record[RESECT_DECL_RECORD_TEMPLATE_ARGUMENT_COUNT]);
+
+    resect_collection specializations = resect_collection_create();
+    resect_reader_type_collection(reader,
+                                  record[RESECT_DECL_RECORD_SPECIALIZATIONS],
+                                  record[RESECT_DECL_RECORD_SPECIALIZATION_COUNT],
+                                  specializations);
+    decl->specializations = NULL;
+    decl->specialization_set = resect_set_create();
+    resect_iterator iter = resect_collection_iterator(specializations);
+    while (resect_iterator_next(iter)) {
+        resect_set_add(decl->specialization_set, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+    resect_collection_free(specializations);
+
+    decl->dependencies = resect_collection_create();
+    resect_reader_decl_collection(reader,
+                                  record[RESECT_DECL_RECORD_DEPENDENCIES],
+                                  record[RESECT_DECL_RECORD_DEPENDENCY_COUNT],
+                                  decl->dependencies);
+    decl->dependents = resect_collection_create();
+    resect_reader_decl_collection(reader,
+                                  record[RESECT_DECL_RECORD_DEPENDENTS],
+                                  record[RESECT_DECL_RECORD_DEPENDENT_COUNT],
+                                  decl->dependents);
+
+    decl->data_deallocator = NULL;
+    decl->data = NULL;
+    resect_decl_data_deserialize(decl, reader, record[RESECT_DECL_RECORD_DATA]);
+}
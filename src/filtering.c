@@ -14,6 +14,9 @@ struct P_resect_filtering_context {
     resect_collection enforced_source_patterns;
     resect_collection ignored_definition_patterns;
     resect_collection ignored_source_patterns;
+    resect_collection root_definition_patterns;
+
+    resect_stats stats;
 };
 
 static resect_collection compile_pattern_collection(resect_collection collection) {
@@ -40,8 +43,8 @@ static void free_pattern_collection(resect_collection collection) {
     resect_collection_free(collection);
 }
 
-resect_filtering_context resect_filtering_context_create(resect_parse_options options) {
-    resect_filtering_context context = malloc(sizeof(struct P_resect_filtering_context));
+resect_filtering_context resect_filtering_context_create(resect_parse_options options, resect_stats stats) {
+    resect_filtering_context context = resect_allocate(sizeof(struct P_resect_filtering_context));
     context->included_definition_patterns =
             compile_pattern_collection(resect_options_get_included_definitions(options));
     context->included_source_patterns = compile_pattern_collection(resect_options_get_included_sources(options));
@@ -54,6 +57,9 @@ resect_filtering_context resect_filtering_context_create(resect_parse_options op
     context->ignored_definition_patterns =
             compile_pattern_collection(resect_options_get_ignored_definitions(options));
     context->ignored_source_patterns = compile_pattern_collection(resect_options_get_ignored_sources(options));
+    context->root_definition_patterns = compile_pattern_collection(resect_options_get_root_definitions(options));
+
+    context->stats = stats;
 
     return context;
 }
@@ -67,13 +73,17 @@ void resect_filtering_context_free(resect_filtering_context context) {
     free_pattern_collection(context->enforced_source_patterns);
     free_pattern_collection(context->ignored_definition_patterns);
     free_pattern_collection(context->ignored_source_patterns);
+    free_pattern_collection(context->root_definition_patterns);
 
-    free(context);
+    resect_deallocate(context);
 }
 
-static bool match_pattern_collection(resect_collection collection, const char *subject) {
+static bool match_pattern_collection(resect_filtering_context context, resect_collection collection,
+                                     const char *subject) {
     bool result = false;
 
+    resect_stats_count(context->stats, RESECT_COUNTER_PATTERN_MATCHES, resect_collection_size(collection));
+
     resect_iterator iter = resect_collection_iterator(collection);
     while (resect_iterator_next(iter)) {
         resect_pattern compiled = resect_iterator_value(iter);
@@ -89,26 +99,34 @@ done:
 
 resect_filter_status resect_filtering_status(resect_filtering_context context, const char *declaration_name,
                                              const char *declaration_source) {
-    if (match_pattern_collection(context->enforced_definition_patterns, declaration_name) ||
-        match_pattern_collection(context->enforced_source_patterns, declaration_source)) {
+    if (match_pattern_collection(context, context->enforced_definition_patterns, declaration_name) ||
+        match_pattern_collection(context, context->enforced_source_patterns, declaration_source)) {
         return RESECT_FILTER_STATUS_ENFORCED;
     }
 
-    if (match_pattern_collection(context->excluded_definition_patterns, declaration_name) ||
-        match_pattern_collection(context->excluded_source_patterns, declaration_source)) {
+    if (match_pattern_collection(context, context->excluded_definition_patterns, declaration_name) ||
+        match_pattern_collection(context, context->excluded_source_patterns, declaration_source)) {
         return RESECT_FILTER_STATUS_EXCLUDED;
         }
 
-    if (match_pattern_collection(context->ignored_definition_patterns, declaration_name) ||
-        match_pattern_collection(context->ignored_source_patterns, declaration_source)) {
+    if (match_pattern_collection(context, context->ignored_definition_patterns, declaration_name) ||
+        match_pattern_collection(context, context->ignored_source_patterns, declaration_source)) {
         return RESECT_FILTER_STATUS_IGNORED;
         }
 
-    if (match_pattern_collection(context->included_definition_patterns, declaration_name) ||
-        match_pattern_collection(context->included_source_patterns, declaration_source)) {
+    if (match_pattern_collection(context, context->included_definition_patterns, declaration_name) ||
+        match_pattern_collection(context, context->included_source_patterns, declaration_source)) {
         return RESECT_FILTER_STATUS_INCLUDED;
     }
 
     return RESECT_FILTER_STATUS_IGNORED;
 }
+
+bool resect_filtering_has_roots(resect_filtering_context context) {
+    return resect_collection_size(context->root_definition_patterns) > 0;
+}
+
+bool resect_filtering_is_root(resect_filtering_context context, const char *declaration_name) {
+    return match_pattern_collection(context, context->root_definition_patterns, declaration_name);
+}
 #endif // RESECT_FILTERING_H
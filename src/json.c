@@ -0,0 +1,417 @@
+#include "../resect.h"
+#include "resect_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * JSON EXPORT
+ *
+ * Every decl and every type reachable from exposed decls is written as a separate line.
+ * Decls are referenced by their ids, types by sequential numbers assigned during the walk.
+ */
+typedef struct P_resect_json_writer {
+    FILE *out;
+
+    resect_set visited_decls;
+    resect_collection decl_queue;
+
+    resect_pointer_table type_ids;
+    resect_collection type_queue;
+    unsigned int type_count;
+} *resect_json_writer;
+
+static void write_json_string(FILE *out, const char *value) {
+    fputc('"', out);
+    for (const unsigned char *c = (const unsigned char *) value; *c != '\0'; ++c) {
+        switch (*c) {
+            case '"':
+                fputs("\\\"", out);
+                break;
+            case '\\':
+                fputs("\\\\", out);
+                break;
+            case '\n':
+                fputs("\\n", out);
+                break;
+            case '\r':
+                fputs("\\r", out);
+                break;
+            case '\t':
+                fputs("\\t", out);
+                break;
+            default:
+                if (*c < 0x20) {
+                    fprintf(out, "\\u%04x", *c);
+                } else {
+                    fputc(*c, out);
+                }
+        }
+    }
+    fputc('"', out);
+}
+
+static void write_string_property(resect_json_writer writer, const char *name, const char *value) {
+    fprintf(writer->out, ",\"%s\":", name);
+    write_json_string(writer->out, value);
+}
+
+static void write_int_property(resect_json_writer writer, const char *name, long long value) {
+    fprintf(writer->out, ",\"%s\":%lld", name, value);
+}
+
+static void write_bool_property(resect_json_writer writer, const char *name, resect_bool value) {
+    fprintf(writer->out, ",\"%s\":%s", name, value ? "true" : "false");
+}
+
+static void write_decl_ref(resect_json_writer writer, resect_decl decl) {
+    if (decl == NULL) {
+        fputs("null", writer->out);
+        return;
+    }
+
+    if (resect_set_add(writer->visited_decls, decl)) {
+        resect_collection_add(writer->decl_queue, decl);
+    }
+    write_json_string(writer->out, resect_decl_get_id(decl));
+}
+
+static void write_type_ref(resect_json_writer writer, resect_type type) {
+    if (type == NULL) {
+        fputs("null", writer->out);
+        return;
+    }
+
+    void *id = resect_pointer_table_get(writer->type_ids, type);
+    if (id == NULL) {
+        // ids are stored shifted by one to tell them apart from missing entries
+        id = (void *) (uintptr_t) (++writer->type_count);
+        resect_pointer_table_put_if_absent(writer->type_ids, type, id);
+        resect_collection_add(writer->type_queue, type);
+    }
+    fprintf(writer->out, "%u", (unsigned int) ((uintptr_t) id - 1));
+}
+
+static void write_decl_property(resect_json_writer writer, const char *name, resect_decl decl) {
+    fprintf(writer->out, ",\"%s\":", name);
+    write_decl_ref(writer, decl);
+}
+
+static void write_type_property(resect_json_writer writer, const char *name, resect_type type) {
+    fprintf(writer->out, ",\"%s\":", name);
+    write_type_ref(writer, type);
+}
+
+static void write_decl_list_property(resect_json_writer writer, const char *name, resect_collection decls) {
+    fprintf(writer->out, ",\"%s\":[", name);
+    int i = 0;
+    resect_iterator iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(iter)) {
+        if (i++ > 0) {
+            fputc(',', writer->out);
+        }
+        write_decl_ref(writer, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+    fputc(']', writer->out);
+}
+
+static void write_type_list_property(resect_json_writer writer, const char *name, resect_collection types) {
+    fprintf(writer->out, ",\"%s\":[", name);
+    int i = 0;
+    resect_iterator iter = resect_collection_iterator(types);
+    while (resect_iterator_next(iter)) {
+        if (i++ > 0) {
+            fputc(',', writer->out);
+        }
+        write_type_ref(writer, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+    fputc(']', writer->out);
+}
+
+static void write_value_property(resect_json_writer writer, resect_variable_kind kind, long long int_value,
+                                 double float_value, const char *string_value) {
+    switch (kind) {
+        case RESECT_VARIABLE_TYPE_INT:
+            write_int_property(writer, "value", int_value);
+            break;
+        case RESECT_VARIABLE_TYPE_FLOAT:
+            if (isfinite(float_value)) {
+                fprintf(writer->out, ",\"value\":%.17g", float_value);
+            } else {
+                fputs(",\"value\":null", writer->out);
+            }
+            break;
+        case RESECT_VARIABLE_TYPE_STRING:
+        case RESECT_VARIABLE_TYPE_OTHER:
+            write_string_property(writer, "value", string_value);
+            break;
+        default:;
+    }
+}
+
+static void write_template_arguments_property(resect_json_writer writer, resect_collection args) {
+    fputs(",\"template_arguments\":[", writer->out);
+    int i = 0;
+    resect_iterator iter = resect_collection_iterator(args);
+    while (resect_iterator_next(iter)) {
+        resect_template_argument arg = resect_iterator_value(iter);
+        if (i++ > 0) {
+            fputc(',', writer->out);
+        }
+        fprintf(writer->out, "{\"kind\":%d", resect_template_argument_get_kind(arg));
+        write_int_property(writer, "position", resect_template_argument_get_position(arg));
+        write_type_property(writer, "type", resect_template_argument_get_type(arg));
+        write_int_property(writer, "value", resect_template_argument_get_value(arg));
+        fputc('}', writer->out);
+    }
+    resect_iterator_free(iter);
+    fputc(']', writer->out);
+}
+
+static void write_function_properties(resect_json_writer writer, resect_collection parameters,
+                                      resect_type result_type, resect_storage_class storage_class,
+                                      resect_bool variadic) {
+    write_decl_list_property(writer, "parameters", parameters);
+    write_type_property(writer, "result_type", result_type);
+    write_int_property(writer, "storage_class", storage_class);
+    write_bool_property(writer, "variadic", variadic);
+}
+
+static void write_decl(resect_json_writer writer, resect_decl decl) {
+    resect_decl_kind kind = resect_decl_get_kind(decl);
+
+    fputs("{\"entity\":\"decl\",\"id\":", writer->out);
+    write_json_string(writer->out, resect_decl_get_id(decl));
+    write_int_property(writer, "kind", kind);
+    write_string_property(writer, "name", resect_decl_get_name(decl));
+    write_string_property(writer, "namespace", resect_decl_get_namespace(decl));
+    write_string_property(writer, "mangled_name", resect_decl_get_mangled_name(decl));
+    write_string_property(writer, "comment", resect_decl_get_comment(decl));
+    write_string_property(writer, "source", resect_decl_get_source(decl));
+
+    resect_location location = resect_decl_get_location(decl);
+    fputs(",\"location\":{\"file\":", writer->out);
+    write_json_string(writer->out, resect_location_name(location));
+    fprintf(writer->out, ",\"line\":%u,\"column\":%u}", resect_location_line(location),
+            resect_location_column(location));
+
+    write_int_property(writer, "access", resect_decl_get_access_specifier(decl));
+    write_int_property(writer, "linkage", resect_decl_get_linkage(decl));
+    write_bool_property(writer, "forward", resect_decl_is_forward(decl));
+    write_bool_property(writer, "template", resect_decl_is_template(decl));
+    write_bool_property(writer, "partial", resect_decl_is_partially_specialized(decl));
+    write_int_property(writer, "symbol_status", resect_decl_get_symbol_status(decl));
+    write_decl_property(writer, "owner", resect_decl_get_owner(decl));
+    write_decl_property(writer, "specialized_template", resect_decl_get_template(decl));
+    write_type_property(writer, "type", resect_decl_get_type(decl));
+    write_decl_list_property(writer, "template_parameters", resect_decl_template_parameters(decl));
+    write_template_arguments_property(writer, resect_decl_template_arguments(decl));
+    write_type_list_property(writer, "specializations", resect_decl_template_specializations(decl));
+
+    switch (kind) {
+        case RESECT_DECL_KIND_STRUCT:
+        case RESECT_DECL_KIND_UNION:
+        case RESECT_DECL_KIND_CLASS:
+            write_decl_list_property(writer, "fields", resect_record_fields(decl));
+            write_decl_list_property(writer, "methods", resect_record_methods(decl));
+            write_type_list_property(writer, "parents", resect_record_parents(decl));
+            write_bool_property(writer, "abstract", resect_record_is_abstract(decl));
+            break;
+        case RESECT_DECL_KIND_FIELD:
+            write_int_property(writer, "offset", resect_field_decl_get_offset(decl));
+            write_bool_property(writer, "bitfield", resect_field_decl_is_bitfield(decl));
+            write_int_property(writer, "width", resect_field_decl_get_width(decl));
+            break;
+        case RESECT_DECL_KIND_ENUM:
+            write_decl_list_property(writer, "constants", resect_enum_constants(decl));
+            write_type_property(writer, "integer_type", resect_enum_get_type(decl));
+            break;
+        case RESECT_DECL_KIND_ENUM_CONSTANT:
+            if (resect_enum_constant_is_unsigned(decl)) {
+                fprintf(writer->out, ",\"value\":%llu", resect_enum_constant_unsigned_value(decl));
+            } else {
+                write_int_property(writer, "value", resect_enum_constant_value(decl));
+            }
+            break;
+        case RESECT_DECL_KIND_FUNCTION:
+            write_function_properties(writer,
+                                      resect_function_parameters(decl),
+                                      resect_function_get_result_type(decl),
+                                      resect_function_get_storage_class(decl),
+                                      resect_function_is_variadic(decl));
+            write_bool_property(writer, "inlined", resect_function_is_inlined(decl));
+            break;
+        case RESECT_DECL_KIND_METHOD:
+            write_function_properties(writer,
+                                      resect_method_parameters(decl),
+                                      resect_method_get_result_type(decl),
+                                      resect_method_get_storage_class(decl),
+                                      resect_method_is_variadic(decl));
+            write_bool_property(writer, "virtual", resect_method_is_virtual(decl));
+            write_bool_property(writer, "pure_virtual", resect_method_is_pure_virtual(decl));
+            write_bool_property(writer, "const", resect_method_is_const(decl));
+            write_bool_property(writer, "deleted", resect_method_is_deleted(decl));
+            break;
+        case RESECT_DECL_KIND_VARIABLE:
+            write_int_property(writer, "value_kind", resect_variable_get_kind(decl));
+            write_int_property(writer, "storage_class", resect_variable_get_storage_class(decl));
+            write_value_property(writer, resect_variable_get_kind(decl), resect_variable_get_value_as_int(decl),
+                                 resect_variable_get_value_as_float(decl), resect_variable_get_value_as_string(decl));
+            break;
+        case RESECT_DECL_KIND_TYPEDEF:
+            write_type_property(writer, "aliased_type", resect_typedef_get_aliased_type(decl));
+            break;
+        case RESECT_DECL_KIND_MACRO:
+            write_bool_property(writer, "function_like", resect_macro_is_function_like(decl));
+            write_int_property(writer, "value_kind", resect_macro_get_value_kind(decl));
+            write_value_property(writer, resect_macro_get_value_kind(decl), resect_macro_get_value_as_int(decl),
+                                 resect_macro_get_value_as_float(decl), resect_macro_get_value_as_string(decl));
+            break;
+        case RESECT_DECL_KIND_TEMPLATE_PARAMETER:
+            write_int_property(writer, "parameter_kind", resect_template_parameter_get_kind(decl));
+            break;
+        default:;
+    }
+
+    fputs("}\n", writer->out);
+}
+
+static void write_type(resect_json_writer writer, resect_type type, unsigned int id) {
+    resect_type_kind kind = resect_type_get_kind(type);
+    resect_type_category category = resect_type_get_category(type);
+
+    fprintf(writer->out, "{\"entity\":\"type\",\"id\":%u", id);
+    write_int_property(writer, "kind", kind);
+    write_string_property(writer, "name", resect_type_get_name(type));
+    write_int_property(writer, "category", category);
+    write_int_property(writer, "size", resect_type_sizeof(type));
+    write_int_property(writer, "alignment", resect_type_alignof(type));
+    write_bool_property(writer, "const", resect_type_is_const_qualified(type));
+    write_bool_property(writer, "pod", resect_type_is_pod(type));
+    write_bool_property(writer, "undeclared", resect_type_is_undeclared(type));
+    write_bool_property(writer, "truncated", resect_type_is_truncated(type));
+    write_bool_property(writer, "opaque", resect_type_is_opaque(type));
+    write_decl_property(writer, "decl", resect_type_get_declaration(type));
+
+    fputs(",\"fields\":[", writer->out);
+    int i = 0;
+    resect_iterator iter = resect_collection_iterator(resect_type_fields(type));
+    while (resect_iterator_next(iter)) {
+        resect_type_field field = resect_iterator_value(iter);
+        if (i++ > 0) {
+            fputc(',', writer->out);
+        }
+        fputs("{\"id\":", writer->out);
+        write_json_string(writer->out, resect_type_field_get_id(field));
+        write_string_property(writer, "name", resect_type_field_get_name(field));
+        write_int_property(writer, "offset", resect_type_field_get_offset(field));
+        write_type_property(writer, "type", resect_type_field_get_type(field));
+        fputc('}', writer->out);
+    }
+    resect_iterator_free(iter);
+    fputc(']', writer->out);
+
+    fputs(",\"methods\":[", writer->out);
+    i = 0;
+    iter = resect_collection_iterator(resect_type_methods(type));
+    while (resect_iterator_next(iter)) {
+        resect_type_method method = resect_iterator_value(iter);
+        if (i++ > 0) {
+            fputc(',', writer->out);
+        }
+        fputs("{\"id\":", writer->out);
+        write_json_string(writer->out, resect_type_method_get_id(method));
+        write_string_property(writer, "name", resect_type_method_get_name(method));
+        write_string_property(writer, "mangled_name", resect_type_method_get_mangled_name(method));
+        write_bool_property(writer, "static", resect_type_method_is_static(method));
+        write_bool_property(writer, "const", resect_type_method_is_const(method));
+        write_type_property(writer, "type", resect_type_method_get_proto(method));
+        write_decl_property(writer, "decl", resect_type_method_get_decl(method));
+        fputc('}', writer->out);
+    }
+    resect_iterator_free(iter);
+    fputc(']', writer->out);
+
+    write_type_list_property(writer, "base_classes", resect_type_base_classes(type));
+    write_template_arguments_property(writer, resect_type_template_arguments(type));
+
+    if (kind == RESECT_TYPE_KIND_FUNCTIONPROTO || kind == RESECT_TYPE_KIND_FUNCTIONNOPROTO) {
+        write_type_property(writer, "result_type", resect_function_proto_get_result_type(type));
+        write_type_list_property(writer, "parameters", resect_function_proto_parameters(type));
+        write_bool_property(writer, "variadic", resect_function_proto_is_variadic(type));
+    } else {
+        switch (category) {
+            case RESECT_TYPE_CATEGORY_POINTER:
+                write_type_property(writer, "pointee", resect_pointer_get_pointee_type(type));
+                if (kind == RESECT_TYPE_KIND_MEMBERPOINTER) {
+                    write_type_property(writer, "owner", resect_member_pointer_get_owning_type(type));
+                }
+                break;
+            case RESECT_TYPE_CATEGORY_REFERENCE:
+                write_type_property(writer, "pointee", resect_reference_get_pointee_type(type));
+                write_bool_property(writer, "lvalue", resect_reference_is_lvalue(type));
+                break;
+            case RESECT_TYPE_CATEGORY_ARRAY:
+                write_type_property(writer, "element", resect_array_get_element_type(type));
+                write_int_property(writer, "length", resect_array_get_size(type));
+                break;
+            default:;
+        }
+    }
+
+    fputs("}\n", writer->out);
+}
+
+resect_bool resect_unit_write_json(resect_translation_unit unit, FILE *out) {
+    struct P_resect_json_writer writer = {
+        .out = out,
+        .visited_decls = resect_set_create(),
+        .decl_queue = resect_collection_create(),
+        .type_ids = resect_pointer_table_create(),
+        .type_queue = resect_collection_create(),
+        .type_count = 0,
+    };
+
+    // exposed decls are written first and must not be queued again when referenced by each other
+    resect_collection exposed = resect_unit_declarations(unit);
+    resect_iterator iter = resect_collection_iterator(exposed);
+    while (resect_iterator_next(iter)) {
+        resect_set_add(writer.visited_decls, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+
+    iter = resect_collection_iterator(exposed);
+    while (resect_iterator_next(iter)) {
+        write_decl(&writer, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+
+    // walk everything referenced by exposed decls, referenced decls and types are queued on first mention
+    unsigned int types_written = 0;
+    while (resect_collection_size(writer.decl_queue) > 0 || types_written < writer.type_count) {
+        while (resect_collection_size(writer.decl_queue) > 0) {
+            resect_decl decl = resect_collection_pop_last(writer.decl_queue);
+            write_decl(&writer, decl);
+        }
+
+        resect_collection types = writer.type_queue;
+        writer.type_queue = resect_collection_create();
+
+        iter = resect_collection_iterator(types);
+        while (resect_iterator_next(iter)) {
+            write_type(&writer, resect_iterator_value(iter), types_written++);
+        }
+        resect_iterator_free(iter);
+        resect_collection_free(types);
+    }
+
+    resect_set_free(writer.visited_decls);
+    resect_collection_free(writer.decl_queue);
+    resect_pointer_table_free(writer.type_ids);
+    resect_collection_free(writer.type_queue);
+
+    return ferror(out) ? resect_false : resect_true;
+}
@@ -3,15 +3,130 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <clang-c/Index.h>
 
+/*
+ * UNSAVED FILES
+ */
+typedef struct P_resect_unsaved_file {
+    char *filename;
+    char *contents;
+    unsigned long length;
+} *resect_unsaved_file;
+
+struct P_resect_unsaved_files {
+    resect_collection files;
+};
+
+resect_unsaved_files resect_unsaved_files_create() {
+    resect_unsaved_files files = resect_allocate(sizeof(struct P_resect_unsaved_files));
+    files->files = resect_collection_create();
+    return files;
+}
+
+void resect_unsaved_files_add(resect_unsaved_files files, const char *filename,
+                              const char *contents, unsigned long length) {
+    resect_unsaved_file file = resect_allocate(sizeof(struct P_resect_unsaved_file));
+
+    size_t filename_length = strlen(filename);
+    file->filename = resect_allocate(filename_length + 1);
+    memcpy(file->filename, filename, filename_length + 1);
+
+    // contents are copied as is, they are not required to be null-terminated
+    file->contents = resect_allocate(length > 0 ? length : 1);
+    memcpy(file->contents, contents, length);
+    file->length = length;
+
+    resect_collection_add(files->files, file);
+}
+
+void resect_unsaved_files_free(resect_unsaved_files files) {
+    resect_iterator iter = resect_collection_iterator(files->files);
+    while (resect_iterator_next(iter)) {
+        resect_unsaved_file file = resect_iterator_value(iter);
+        resect_deallocate(file->filename);
+        resect_deallocate(file->contents);
+        resect_deallocate(file);
+    }
+    resect_iterator_free(iter);
+    resect_collection_free(files->files);
+    resect_deallocate(files);
+}
+
+static void unsaved_files_add_all(resect_unsaved_files files, resect_unsaved_files other) {
+    resect_iterator iter = resect_collection_iterator(other->files);
+    while (resect_iterator_next(iter)) {
+        resect_unsaved_file file = resect_iterator_value(iter);
+        resect_unsaved_files_add(files, file->filename, file->contents, file->length);
+    }
+    resect_iterator_free(iter);
+}
+
+static bool unsaved_files_contain(struct CXUnsavedFile *files, unsigned int count, const char *filename) {
+    for (unsigned int i = 0; i < count; ++i) {
+        if (strcmp(files[i].Filename, filename) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Files from overrides take precedence over files with the same name from defaults, either can be NULL.
+ * Returned array points into the unsaved files and must be released with resect_deallocate().
+ */
+static struct CXUnsavedFile *unsaved_files_to_clang(resect_unsaved_files overrides, resect_unsaved_files defaults,
+                                                    unsigned int *count) {
+    unsigned int capacity = (overrides != NULL ? resect_collection_size(overrides->files) : 0)
+                            + (defaults != NULL ? resect_collection_size(defaults->files) : 0);
+    *count = 0;
+    if (capacity == 0) {
+        return NULL;
+    }
+
+    struct CXUnsavedFile *result = resect_allocate(capacity * sizeof(struct CXUnsavedFile));
+    resect_unsaved_files sources[] = {overrides, defaults};
+    for (int source = 0; source < 2; ++source) {
+        if (sources[source] == NULL) {
+            continue;
+        }
+
+        resect_iterator iter = resect_collection_iterator(sources[source]->files);
+        while (resect_iterator_next(iter)) {
+            resect_unsaved_file file = resect_iterator_value(iter);
+            if (unsaved_files_contain(result, *count, file->filename)) {
+                continue;
+            }
+            result[*count].Filename = file->filename;
+            result[*count].Contents = file->contents;
+            result[*count].Length = file->length;
+            ++*count;
+        }
+        resect_iterator_free(iter);
+    }
+
+    return result;
+}
+
 /*
  * PARSER
  */
 struct P_resect_parse_options {
     resect_collection args;
     resect_bool single;
+    resect_bool sort_by_location;
+    resect_bool reparseable;
+    resect_unsaved_files unsaved_files;
+    unsigned long long memory_limit;
+    unsigned int template_depth_limit;
+    unsigned int specialization_limit;
+    unsigned int parallel_workers;
+    resect_bool opaque_through_pointers;
+    resect_bool public_only;
+    resect_bool skip_evaluation;
+    resect_bool evaluate_macros;
     resect_diagnostics_level diagnostics_level;
 
     resect_collection included_definition_patterns;
@@ -22,6 +137,8 @@ struct P_resect_parse_options {
     resect_collection enforced_source_patterns;
     resect_collection ignored_definition_patterns;
     resect_collection ignored_source_patterns;
+    resect_collection root_definition_patterns;
+    unsigned int root_hop_limit;
 };
 
 void resect_options_add(resect_parse_options opts, const char *key, const char *value) {
@@ -42,9 +159,20 @@ void resect_options_add_string_c(resect_parse_options opts, const char* string)
 }
 
 resect_parse_options resect_options_create() {
-    resect_parse_options opts = malloc(sizeof(struct P_resect_parse_options));
+    resect_parse_options opts = resect_allocate(sizeof(struct P_resect_parse_options));
     opts->args = resect_collection_create();
     opts->single = resect_false;
+    opts->sort_by_location = resect_false;
+    opts->reparseable = resect_false;
+    opts->unsaved_files = resect_unsaved_files_create();
+    opts->memory_limit = 0;
+    opts->template_depth_limit = 0;
+    opts->specialization_limit = 0;
+    opts->parallel_workers = 0;
+    opts->opaque_through_pointers = resect_false;
+    opts->public_only = resect_false;
+    opts->skip_evaluation = resect_false;
+    opts->evaluate_macros = resect_false;
     opts->diagnostics_level = RESECT_DIAGNOSTICS_NONE;
 
     opts->included_definition_patterns = resect_collection_create();
@@ -58,6 +186,9 @@ resect_parse_options resect_options_create() {
     opts->ignored_definition_patterns = resect_collection_create();
     opts->ignored_source_patterns = resect_collection_create();
 
+    opts->root_definition_patterns = resect_collection_create();
+    opts->root_hop_limit = 0;
+
     resect_collection_add(opts->args, resect_string_from_c("-ferror-limit=0"));
     resect_collection_add(opts->args, resect_string_from_c("-fno-implicit-templates"));
     resect_collection_add(opts->args, resect_string_from_c("-fc++-abi=itanium"));
@@ -81,7 +212,46 @@ void resect_options_free(resect_parse_options opts) {
     resect_string_collection_free(opts->ignored_definition_patterns);
     resect_string_collection_free(opts->ignored_source_patterns);
 
-    free(opts);
+    resect_string_collection_free(opts->root_definition_patterns);
+
+    resect_unsaved_files_free(opts->unsaved_files);
+
+    resect_deallocate(opts);
+}
+
+static resect_collection copy_string_collection(resect_collection strings) {
+    resect_collection result = resect_collection_create();
+    resect_iterator iter = resect_collection_iterator(strings);
+    while (resect_iterator_next(iter)) {
+        resect_collection_add(result, resect_string_copy(resect_iterator_value(iter)));
+    }
+    resect_iterator_free(iter);
+    return result;
+}
+
+static resect_parse_options resect_options_copy(resect_parse_options opts) {
+    resect_parse_options copy = resect_allocate(sizeof(struct P_resect_parse_options));
+    *copy = *opts;
+
+    copy->args = copy_string_collection(opts->args);
+
+    copy->included_definition_patterns = copy_string_collection(opts->included_definition_patterns);
+    copy->included_source_patterns = copy_string_collection(opts->included_source_patterns);
+    copy->excluded_definition_patterns = copy_string_collection(opts->excluded_definition_patterns);
+    copy->excluded_source_patterns = copy_string_collection(opts->excluded_source_patterns);
+
+    copy->enforced_definition_patterns = copy_string_collection(opts->enforced_definition_patterns);
+    copy->enforced_source_patterns = copy_string_collection(opts->enforced_source_patterns);
+
+    copy->ignored_definition_patterns = copy_string_collection(opts->ignored_definition_patterns);
+    copy->ignored_source_patterns = copy_string_collection(opts->ignored_source_patterns);
+
+    copy->root_definition_patterns = copy_string_collection(opts->root_definition_patterns);
+
+    copy->unsaved_files = resect_unsaved_files_create();
+    unsaved_files_add_all(copy->unsaved_files, opts->unsaved_files);
+
+    return copy;
 }
 
 void resect_options_include_definition(resect_parse_options opts, const char *name) {
@@ -116,6 +286,14 @@ void resect_options_ignore_source(resect_parse_options opts, const char *name) {
     resect_collection_add(opts->ignored_source_patterns, resect_string_from_c(name));
 }
 
+void resect_options_root_definition(resect_parse_options opts, const char *name) {
+    resect_collection_add(opts->root_definition_patterns, resect_string_from_c(name));
+}
+
+void resect_options_root_hop_limit(resect_parse_options opts, unsigned int hops) {
+    opts->root_hop_limit = hops;
+}
+
 resect_collection resect_options_get_included_definitions(resect_parse_options opts) {
     return opts->included_definition_patterns;
 }
@@ -148,6 +326,14 @@ resect_collection resect_options_get_ignored_sources(resect_parse_options opts)
     return opts->ignored_source_patterns;
 }
 
+resect_collection resect_options_get_root_definitions(resect_parse_options opts) {
+    return opts->root_definition_patterns;
+}
+
+unsigned int resect_options_current_root_hop_limit(resect_parse_options opts) {
+    return opts->root_hop_limit;
+}
+
 resect_diagnostics_level resect_options_current_diagnostics_level(resect_parse_options opts) {
     return opts->diagnostics_level;
 }
@@ -241,6 +427,79 @@ void resect_options_single_header(resect_parse_options opts) {
     opts->single = resect_true;
 }
 
+void resect_options_sort_by_location(resect_parse_options opts) {
+    opts->sort_by_location = resect_true;
+}
+
+void resect_options_add_unsaved_file(resect_parse_options opts, const char *path,
+                                     const char *contents, unsigned long length) {
+    resect_unsaved_files_add(opts->unsaved_files, path, contents, length);
+}
+
+void resect_options_memory_limit(resect_parse_options opts, unsigned long long bytes) {
+    opts->memory_limit = bytes;
+}
+
+unsigned long long resect_options_current_memory_limit(resect_parse_options opts) {
+    return opts->memory_limit;
+}
+
+void resect_options_template_depth_limit(resect_parse_options opts, unsigned int depth) {
+    opts->template_depth_limit = depth;
+}
+
+unsigned int resect_options_current_template_depth_limit(resect_parse_options opts) {
+    return opts->template_depth_limit;
+}
+
+void resect_options_specialization_limit(resect_parse_options opts, unsigned int count) {
+    opts->specialization_limit = count;
+}
+
+unsigned int resect_options_current_specialization_limit(resect_parse_options opts) {
+    return opts->specialization_limit;
+}
+
+void resect_options_parallel(resect_parse_options opts, unsigned int workers) {
+    opts->parallel_workers = workers;
+}
+
+void resect_options_opaque_through_pointers(resect_parse_options opts) {
+    opts->opaque_through_pointers = resect_true;
+}
+
+resect_bool resect_options_current_opaque_through_pointers(resect_parse_options opts) {
+    return opts->opaque_through_pointers;
+}
+
+void resect_options_public_only(resect_parse_options opts) {
+    opts->public_only = resect_true;
+}
+
+resect_bool resect_options_current_public_only(resect_parse_options opts) {
+    return opts->public_only;
+}
+
+void resect_options_skip_evaluation(resect_parse_options opts) {
+    opts->skip_evaluation = resect_true;
+}
+
+resect_bool resect_options_current_skip_evaluation(resect_parse_options opts) {
+    return opts->skip_evaluation;
+}
+
+void resect_options_evaluate_macros(resect_parse_options opts) {
+    opts->evaluate_macros = resect_true;
+}
+
+resect_bool resect_options_current_evaluate_macros(resect_parse_options opts) {
+    return opts->evaluate_macros;
+}
+
+void resect_options_reparseable(resect_parse_options opts) {
+    opts->reparseable = resect_true;
+}
+
 void resect_options_print_diagnostics(resect_parse_options opts) {
     opts->diagnostics_level = RESECT_DIAGNOSTICS_WARNING;
 }
@@ -255,6 +514,17 @@ void resect_options_diagnostics_level(resect_parse_options opts, resect_diagnost
 struct P_resect_translation_unit {
     resect_collection declarations;
     resect_translation_context context;
+    // qualified name -> decl, built on first lookup
+    resect_table name_index;
+    resect_collection sorted_declarations;
+    resect_stats stats;
+
+    // kept alive only for reparseable units
+    CXIndex index;
+    CXTranslationUnit clang_unit;
+    resect_parse_options options;
+    // file name -> content hash of files the unit was materialized from, to find changed ones on reparse
+    resect_table file_hashes;
 };
 
 resect_collection resect_unit_declarations(resect_translation_unit unit) {
@@ -265,31 +535,316 @@ resect_language resect_unit_get_language(resect_translation_unit unit) {
     return resect_get_assumed_language(unit->context);
 }
 
-resect_translation_unit resect_parse(const char *filename, resect_parse_options options) {
-    int clang_argc = (int) resect_collection_size(options->args);
-    char **clang_argv = malloc(clang_argc * sizeof(char *));
+resect_bool resect_unit_save(resect_translation_unit unit, const char *path) {
+    return resect_serialize(unit->context, unit->declarations, path) ? resect_true : resect_false;
+}
 
+resect_translation_unit resect_unit_load(const char *path) {
+    resect_translation_context context = resect_deserialize(path);
+    if (context == NULL) {
+        return NULL;
+    }
 
-    if (options->diagnostics_level >= RESECT_DIAGNOSTICS_DEBUG) {
-            fprintf(stderr, "(libresect) libclang args:");
+    resect_translation_unit result = resect_allocate(sizeof(struct P_resect_translation_unit));
+    result->context = context;
+    result->name_index = NULL;
+    result->sorted_declarations = NULL;
+    result->declarations = resect_create_decl_collection(context);
+    result->stats = resect_stats_create();
+    result->index = NULL;
+    result->clang_unit = NULL;
+    result->options = NULL;
+    result->file_hashes = NULL;
+    return result;
+}
+
+double resect_unit_phase_wall_time(resect_translation_unit unit, resect_phase phase) {
+    return resect_stats_wall_time(unit->stats, phase);
+}
+
+double resect_unit_phase_cpu_time(resect_translation_unit unit, resect_phase phase) {
+    return resect_stats_cpu_time(unit->stats, phase);
+}
+
+unsigned long long resect_unit_counter(resect_translation_unit unit, resect_counter counter) {
+    return resect_stats_counter(unit->stats, counter);
+}
+
+resect_bool resect_unit_check_symbols(resect_translation_unit unit, const char *library_path) {
+    resect_symbol_table symbols = resect_symbol_table_load(library_path);
+    if (symbols == NULL) {
+        return resect_false;
+    }
+
+    resect_context_update_symbol_status(unit->context, symbols);
+    resect_symbol_table_free(symbols);
+    return resect_true;
+}
+
+resect_decl resect_unit_find_decl_by_id(resect_translation_unit unit, const char *id) {
+    return resect_context_find_registered_decl(unit->context, id);
+}
+
+static void index_decls_by_name(resect_table name_index, resect_collection decls) {
+    resect_iterator iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(iter)) {
+        resect_decl decl = resect_iterator_value(iter);
+        if (resect_decl_is_anonymous(decl)) {
+            continue;
+        }
+
+        resect_string qualified_name = resect_decl_qualified_name(decl);
+        resect_table_put_if_absent(name_index, resect_string_to_c(qualified_name), decl);
+        resect_string_free(qualified_name);
+    }
+    resect_iterator_free(iter);
+}
+
+resect_decl resect_unit_find_decl_by_name(resect_translation_unit unit, const char *qualified_name) {
+    if (unit->name_index == NULL) {
+        unit->name_index = resect_table_create();
+        // exposed decls go first, so among overloads and specializations the first exposed one is found
+        index_decls_by_name(unit->name_index, unit->declarations);
+
+        resect_collection registered_decls = resect_context_registered_decls(unit->context);
+        index_decls_by_name(unit->name_index, registered_decls);
+        resect_collection_free(registered_decls);
+    }
+    return resect_table_get(unit->name_index, qualified_name);
+}
+
+resect_collection resect_unit_declarations_sorted(resect_translation_unit unit) {
+    if (unit->sorted_declarations == NULL) {
+        unit->sorted_declarations = resect_decl_sort_by_dependencies(unit->declarations);
+    }
+    return unit->sorted_declarations;
+}
+
+/*
+ * PARTITION
+ */
+typedef struct P_resect_partition {
+    unsigned int index;
+    unsigned int count;
+    unsigned int ordinal;
+
+    resect_visit_context parse_visit_context;
+    resect_decl_visit_data decl_visit_data;
+} *resect_partition;
+
+static void parse_partition(resect_visit_context visit_context, CXCursor cursor, void *data) {
+    resect_partition partition = data;
+
+    // every worker walks the same cursors in the same order, so ordinals agree between workers
+    unsigned int ordinal = partition->ordinal++;
+    if (ordinal % partition->count != partition->index) {
+        return;
+    }
+
+    resect_decl_parse(partition->parse_visit_context, cursor, partition->decl_visit_data);
+}
+
+/*
+ * MATERIALIZATION
+ */
+static void evaluate_macros(CXTranslationUnit clang_unit, resect_collection macros, resect_parse_options options,
+                            resect_unsaved_files overrides);
+
+static enum CXTranslationUnit_Flags evaluation_unit_flags(resect_parse_options options);
+
+static resect_shaking_context shake_unit(CXTranslationUnit clang_unit, resect_parse_options options,
+                                         resect_stats stats) {
+    resect_stats_phase_begin(stats, RESECT_PHASE_SHAKING);
+    resect_shaking_context shaking_context = resect_shaking_context_create(options, stats);
+    resect_visit_context shake_visit_context = resect_visit_context_create(resect_decl_shake, stats);
+    resect_visit_cursor_children(shake_visit_context, clang_getTranslationUnitCursor(clang_unit), shaking_context);
+    resect_visit_context_free(shake_visit_context);
+    resect_stats_phase_end(stats, RESECT_PHASE_SHAKING);
+
+    return shaking_context;
+}
+
+static resect_inclusion_registry create_inclusion_registry(resect_shaking_context shaking_context,
+                                                           resect_stats stats) {
+    resect_stats_phase_begin(stats, RESECT_PHASE_REGISTRY_INIT);
+    resect_inclusion_registry inclusion_registry =
+            resect_inclusion_registry_create(shaking_context);
+    resect_stats_phase_end(stats, RESECT_PHASE_REGISTRY_INIT);
+
+    return inclusion_registry;
+}
+
+/**
+ * Materializes decls of the whole unit or only of the partition, if one is given, into the context.
+ * Contexts of parallel workers share their registries, so every worker materializes into the same one.
+ */
+static void parse_context(CXTranslationUnit clang_unit, resect_translation_context translation_context,
+                          resect_stats stats, resect_partition partition) {
+    CXCursor cursor = clang_getTranslationUnitCursor(clang_unit);
+
+    // memory budget only counts what this context allocates, not other parses running in the process
+    resect_memory_account previous_account =
+            resect_memory_account_switch(resect_context_memory_account(translation_context));
+    resect_context_init_printing_policy(translation_context, cursor);
+
+    resect_visit_context parse_visit_context =
+            resect_visit_context_create(resect_decl_parse, stats);
+    resect_decl_visit_data decl_visit_data =
+            resect_decl_visit_data_create(translation_context);
+    if (partition == NULL) {
+        resect_visit_cursor_children(parse_visit_context, cursor, decl_visit_data);
+    } else {
+        partition->parse_visit_context = parse_visit_context;
+        partition->decl_visit_data = decl_visit_data;
+
+        resect_visit_context partition_visit_context = resect_visit_context_create(parse_partition, stats);
+        resect_visit_cursor_children(partition_visit_context, cursor, partition);
+        resect_visit_context_free(partition_visit_context);
     }
+    resect_visit_decl_data_free(decl_visit_data);
+    resect_visit_context_free(parse_visit_context);
+
+    resect_context_release_printing_policy(translation_context);
+    resect_memory_account_switch(previous_account);
+}
+
+static resect_translation_context materialize_context(CXTranslationUnit clang_unit, resect_parse_options options,
+                                                      resect_stats stats, resect_decl_consumer consumer,
+                                                      void *user_data) {
+    resect_shaking_context shaking_context = shake_unit(clang_unit, options, stats);
+    resect_inclusion_registry inclusion_registry = create_inclusion_registry(shaking_context, stats);
+
+    resect_stats_phase_begin(stats, RESECT_PHASE_PARSE);
+    resect_translation_context translation_context = resect_context_create(options, inclusion_registry);
+    resect_context_set_stats(translation_context, stats);
+    resect_context_set_decl_consumer(translation_context, consumer, user_data);
+    parse_context(clang_unit, translation_context, stats, NULL);
+
+    // shaking graph is kept until now to link dependencies of materialized decls
+    resect_shaking_context_link_dependencies(shaking_context, translation_context);
+
+    // evaluation reparses the unit, so it goes after everything that reads the parsed one
+    evaluate_macros(clang_unit, resect_context_macros(translation_context), options, NULL);
+    resect_context_release_macros(translation_context);
+
+    resect_context_set_decl_consumer(translation_context, NULL, NULL);
+    resect_context_set_stats(translation_context, NULL);
+    resect_stats_phase_end(stats, RESECT_PHASE_PARSE);
+
+    resect_stats_phase_begin(stats, RESECT_PHASE_TEARDOWN);
+    resect_shaking_context_free(shaking_context);
+    resect_inclusion_registry_free(inclusion_registry);
+    resect_stats_phase_end(stats, RESECT_PHASE_TEARDOWN);
+
+    return translation_context;
+}
+
+/**
+ * Materializes decls of changed files and decls referring to them into the context of the unit again,
+ * other decls are found in its registry as they are.
+ */
+static void rematerialize_context(resect_translation_unit unit, resect_table changed_files,
+                                  resect_unsaved_files overrides) {
+    CXTranslationUnit clang_unit = unit->clang_unit;
+    resect_parse_options options = unit->options;
+    resect_stats stats = unit->stats;
+    resect_translation_context translation_context = unit->context;
+
+    resect_shaking_context shaking_context = shake_unit(clang_unit, options, stats);
+    resect_inclusion_registry inclusion_registry = create_inclusion_registry(shaking_context, stats);
+
+    resect_stats_phase_begin(stats, RESECT_PHASE_PARSE);
+    resect_context_set_inclusion_registry(translation_context, inclusion_registry);
+    resect_context_invalidate(translation_context, changed_files);
+    resect_context_set_stats(translation_context, stats);
+    parse_context(clang_unit, translation_context, stats, NULL);
+
+    resect_shaking_context_link_dependencies(shaking_context, translation_context);
+
+    evaluate_macros(clang_unit, resect_context_macros(translation_context), options, overrides);
+    resect_context_release_macros(translation_context);
+
+    resect_context_set_stats(translation_context, NULL);
+    resect_stats_phase_end(stats, RESECT_PHASE_PARSE);
+
+    resect_stats_phase_begin(stats, RESECT_PHASE_TEARDOWN);
+    resect_shaking_context_free(shaking_context);
+    resect_inclusion_registry_free(inclusion_registry);
+    resect_stats_phase_end(stats, RESECT_PHASE_TEARDOWN);
+}
+
+static void collect_unit_declarations(resect_translation_unit unit, resect_parse_options options) {
+    unit->name_index = NULL;
+    unit->sorted_declarations = NULL;
+    unit->declarations = resect_create_decl_collection(unit->context);
+    if (options->sort_by_location) {
+        resect_collection_sort(unit->declarations, resect_decl_compare_location);
+    }
+}
+
+static void release_unit_declaration_collections(resect_translation_unit unit) {
+    if (unit->name_index != NULL) {
+        resect_table_free(unit->name_index, NULL, NULL);
+    }
+    if (unit->sorted_declarations != NULL) {
+        resect_decl_group_collection_free(unit->sorted_declarations);
+    }
+    resect_collection_free(unit->declarations);
+
+    unit->name_index = NULL;
+    unit->sorted_declarations = NULL;
+    unit->declarations = NULL;
+}
+
+static void materialize_unit(resect_translation_unit unit, CXTranslationUnit clang_unit,
+                             resect_parse_options options, resect_decl_consumer consumer, void *user_data) {
+    unit->context = materialize_context(clang_unit, options, unit->stats, consumer, user_data);
+    collect_unit_declarations(unit, options);
+}
+
+static void release_unit_declarations(resect_translation_unit unit) {
+    resect_set deallocated = resect_set_create();
+    resect_context_free(unit->context, deallocated);
+    release_unit_declaration_collections(unit);
+    resect_set_free(deallocated);
+
+    unit->context = NULL;
+}
+
+static CXIndex create_index(resect_parse_options options) {
+    return clang_createIndex(0, (options->diagnostics_level >= RESECT_DIAGNOSTICS_WARNING) ? 1 : 0);
+}
+
+/**
+ * Returned array points into the options and must be released with resect_deallocate().
+ */
+static char **create_clang_args(resect_parse_options options, int *argc) {
+    *argc = (int) resect_collection_size(options->args);
+    char **argv = resect_allocate(*argc * sizeof(char *));
+
     resect_iterator arg_iter = resect_collection_iterator(options->args);
     int i = 0;
     while (resect_iterator_next(arg_iter)) {
         resect_string arg = resect_iterator_value(arg_iter);
-        clang_argv[i++] = (char *) resect_string_to_c(arg);
-        if (options->diagnostics_level >= RESECT_DIAGNOSTICS_DEBUG) {
-            fprintf(stderr, " %s", resect_string_to_c(arg));
-        }
+        argv[i++] = (char *) resect_string_to_c(arg);
     }
+    resect_iterator_free(arg_iter);
+
+    return argv;
+}
+
+static CXTranslationUnit create_clang_unit(CXIndex index, const char *filename, resect_parse_options options,
+                                           enum CXTranslationUnit_Flags extra_flags, resect_stats stats) {
+    int clang_argc = 0;
+    char **clang_argv = create_clang_args(options, &clang_argc);
+
     if (options->diagnostics_level >= RESECT_DIAGNOSTICS_DEBUG) {
+        fprintf(stderr, "(libresect) libclang args:");
+        for (int i = 0; i < clang_argc; ++i) {
+            fprintf(stderr, " %s", clang_argv[i]);
+        }
         fprintf(stderr, "\n");
     }
-    resect_iterator_free(arg_iter);
-
-    CXIndex index = clang_createIndex(0,
-        (options->diagnostics_level >= RESECT_DIAGNOSTICS_WARNING) ? 1 : 0);
-    clang_toggleCrashRecovery(false);
 
     enum CXTranslationUnit_Flags unitFlags = CXTranslationUnit_DetailedPreprocessingRecord |
                                              CXTranslationUnit_KeepGoing |
@@ -301,53 +856,523 @@ resect_translation_unit resect_parse(const char *filename, resect_parse_options
         unitFlags |= CXTranslationUnit_SingleFileParse;
     }
 
+    if (options->reparseable) {
+        // preamble lets clang skip reparsing unchanged leading includes on reparse
+        unitFlags |= CXTranslationUnit_PrecompiledPreamble |
+                     CXTranslationUnit_CreatePreambleOnFirstParse;
+    }
+
+    unitFlags |= extra_flags;
+
+    unsigned int unsaved_count = 0;
+    struct CXUnsavedFile *unsaved_files = unsaved_files_to_clang(NULL, options->unsaved_files, &unsaved_count);
+
+    resect_stats_phase_begin(stats, RESECT_PHASE_CLANG_PARSE);
+
     CXTranslationUnit clangUnit = clang_parseTranslationUnit(index, filename,
                                                              (const char *const *) clang_argv,
                                                              clang_argc,
-                                                             NULL,
-                                                             0, unitFlags);
+                                                             unsaved_files,
+                                                             unsaved_count, unitFlags);
+    resect_stats_phase_end(stats, RESECT_PHASE_CLANG_PARSE);
+    resect_deallocate(unsaved_files);
+    resect_deallocate(clang_argv);
+
+    return clangUnit;
+}
 
-    CXCursor cursor = clang_getTranslationUnitCursor(clangUnit);
+/*
+ * FILE HASHES
+ */
+typedef struct P_resect_file_hash_visit_data {
+    CXTranslationUnit clang_unit;
+    resect_table hashes;
+} *resect_file_hash_visit_data;
+
+static void hash_included_file(CXFile file, CXSourceLocation *inclusion_stack, unsigned int include_length,
+                               CXClientData data) {
+    resect_file_hash_visit_data visit_data = data;
+
+    CXString filename = clang_getFileName(file);
+    if (resect_table_get(visit_data->hashes, clang_getCString(filename)) == NULL) {
+        unsigned long long *hash = resect_allocate(sizeof(unsigned long long));
+
+        size_t length = 0;
+        const char *contents = clang_getFileContents(visit_data->clang_unit, file, &length);
+        if (contents != NULL) {
+            *hash = resect_hash_buffer(contents, length);
+        } else {
+            // contents of files clang doesn't keep are told apart by modification time
+            time_t modification_time = clang_getFileTime(file);
+            *hash = resect_hash_buffer(&modification_time, sizeof(time_t));
+        }
+        resect_table_put(visit_data->hashes, clang_getCString(filename), hash);
+    }
+    clang_disposeString(filename);
+}
 
+/**
+ * Must be called before macros are evaluated, evaluation appends to the main file of the unit.
+ * @return table of file name -> content hash of every file in the unit, freed with free_file_hashes()
+ */
+static resect_table hash_unit_files(CXTranslationUnit clang_unit) {
+    struct P_resect_file_hash_visit_data visit_data = {
+        .clang_unit = clang_unit,
+        .hashes = resect_table_create()
+    };
+    clang_getInclusions(clang_unit, hash_included_file, &visit_data);
+    return visit_data.hashes;
+}
 
-    resect_shaking_context shaking_context = resect_shaking_context_create(options);
-    resect_visit_context shake_visit_context = resect_visit_context_create(resect_decl_shake);
-    resect_visit_cursor_children(shake_visit_context, cursor, shaking_context);
-    resect_visit_context_free(shake_visit_context);
+static void free_file_hash(void *context, void *value) {
+    resect_deallocate(value);
+}
 
-    resect_inclusion_registry inclusion_registry =
-            resect_inclusion_registry_create(shaking_context);
-    resect_shaking_context_free(shaking_context);
+static void free_file_hashes(resect_table hashes) {
+    resect_table_free(hashes, free_file_hash, NULL);
+}
 
-    resect_translation_context translation_context = resect_context_create(options, inclusion_registry);
-    resect_context_init_printing_policy(translation_context, cursor);
+typedef struct P_resect_file_hash_comparison {
+    resect_table other_hashes;
+    resect_table changed_files;
+} *resect_file_hash_comparison;
+
+static resect_bool compare_file_hash(void *ctx, const char *filename, void *value) {
+    resect_file_hash_comparison comparison = ctx;
+    unsigned long long *hash = value;
+    unsigned long long *other_hash = resect_table_get(comparison->other_hashes, filename);
+    if (other_hash == NULL || *other_hash != *hash) {
+        resect_table_put(comparison->changed_files, filename, hash);
+    }
+    return resect_true;
+}
 
-    resect_visit_context parse_visit_context =
-            resect_visit_context_create(resect_decl_parse);
-    resect_decl_visit_data decl_visit_data =
-            resect_decl_visit_data_create(translation_context);
-    resect_visit_cursor_children(parse_visit_context, cursor, decl_visit_data);
-    resect_visit_decl_data_free(decl_visit_data);
-    resect_visit_context_free(parse_visit_context);
+/**
+ * @return table with names of files added, removed or changed since the previous hashes as keys,
+ * values point into the hash tables
+ */
+static resect_table find_changed_files(resect_table previous_hashes, resect_table current_hashes) {
+    resect_table changed_files = resect_table_create();
 
-    resect_context_release_printing_policy(translation_context);
-    clang_disposeTranslationUnit(clangUnit);
-    clang_disposeIndex(index);
-    free(clang_argv);
+    struct P_resect_file_hash_comparison comparison = {
+        .other_hashes = previous_hashes,
+        .changed_files = changed_files
+    };
+    resect_visit_table(current_hashes, compare_file_hash, &comparison);
+
+    comparison.other_hashes = current_hashes;
+    resect_visit_table(previous_hashes, compare_file_hash, &comparison);
+
+    return changed_files;
+}
+
+/*
+ * MACRO EVALUATION
+ */
+#define MACRO_VALUE_PREFIX "resect_macro_value_"
+
+typedef struct P_resect_macro_evaluation {
+    resect_decl *macros;
+    unsigned int count;
+} *resect_macro_evaluation;
+
+static enum CXChildVisitResult evaluate_macro_value(CXCursor cursor, CXCursor parent, CXClientData data) {
+    resect_macro_evaluation evaluation = data;
+    if (clang_getCursorKind(cursor) != CXCursor_VarDecl
+        || !clang_Location_isFromMainFile(clang_getCursorLocation(cursor))) {
+        return CXChildVisit_Continue;
+    }
+
+    CXString spelling = clang_getCursorSpelling(cursor);
+    const char *name = clang_getCString(spelling);
+    if (strncmp(name, MACRO_VALUE_PREFIX, strlen(MACRO_VALUE_PREFIX)) == 0) {
+        unsigned long index = strtoul(name + strlen(MACRO_VALUE_PREFIX), NULL, 10);
+        CXEvalResult value = index < evaluation->count ? clang_Cursor_Evaluate(cursor) : NULL;
+        if (value != NULL) {
+            resect_macro_evaluate(evaluation->macros[index], value);
+            clang_EvalResult_dispose(value);
+        }
+    }
+    clang_disposeString(spelling);
+
+    return CXChildVisit_Continue;
+}
+
+/**
+ * Evaluates object-like macros in the parsed unit itself: constants initialized with replacement lists of macros
+ * are appended to the main file and the unit is reparsed with it, which reuses the preamble of the first parse.
+ */
+static void evaluate_macros(CXTranslationUnit clang_unit, resect_collection macros, resect_parse_options options,
+                            resect_unsaved_files overrides) {
+    unsigned int count = resect_collection_size(macros);
+    // evaluation reparses the unit, so it is only done on request
+    if (!options->evaluate_macros || options->skip_evaluation || count == 0) {
+        return;
+    }
+
+    CXString filename = clang_getTranslationUnitSpelling(clang_unit);
+    CXFile main_file = clang_getFile(clang_unit, clang_getCString(filename));
+    size_t main_file_length = 0;
+    const char *main_file_contents = main_file == NULL
+                                     ? NULL : clang_getFileContents(clang_unit, main_file, &main_file_length);
+    if (main_file_contents == NULL) {
+        if (options->diagnostics_level >= RESECT_DIAGNOSTICS_WARNING) {
+            fprintf(stderr, "(libresect) Failed to read %s to evaluate macros\n", clang_getCString(filename));
+        }
+        clang_disposeString(filename);
+        return;
+    }
+
+    struct P_resect_macro_evaluation evaluation = {
+        .macros = resect_allocate(count * sizeof(resect_decl)),
+        .count = count
+    };
+    // appended after the last line, so locations of materialized decls stay the same
+    resect_string values = resect_string_from_c("\n");
+    resect_iterator iter = resect_collection_iterator(macros);
+    unsigned int index = 0;
+    while (resect_iterator_next(iter)) {
+        resect_decl macro = resect_iterator_value(iter);
+        evaluation.macros[index] = macro;
+
+        resect_string value = resect_string_format("static const __auto_type " MACRO_VALUE_PREFIX "%u = (%s);\n",
+                                                   index, resect_macro_body(macro));
+        resect_string_append(values, value);
+        resect_string_free(value);
+        ++index;
+    }
+    resect_iterator_free(iter);
+
+    // contents belong to the unit and don't survive the reparse, so they are copied first
+    size_t source_length = main_file_length + resect_string_length(values);
+    char *source = resect_allocate(source_length);
+    memcpy(source, main_file_contents, main_file_length);
+    memcpy(source + main_file_length, resect_string_to_c(values), resect_string_length(values));
+
+    resect_unsaved_files evaluation_files = resect_unsaved_files_create();
+    resect_unsaved_files_add(evaluation_files, clang_getCString(filename), source, source_length);
+    if (overrides != NULL) {
+        unsaved_files_add_all(evaluation_files, overrides);
+    }
+
+    unsigned int unsaved_count = 0;
+    struct CXUnsavedFile *unsaved_files = unsaved_files_to_clang(evaluation_files, options->unsaved_files,
+                                                                 &unsaved_count);
+    int error = clang_reparseTranslationUnit(clang_unit, unsaved_count, unsaved_files,
+                                             clang_defaultReparseOptions(clang_unit));
+    if (error == 0) {
+        clang_visitChildren(clang_getTranslationUnitCursor(clang_unit), evaluate_macro_value, &evaluation);
+    } else if (options->diagnostics_level >= RESECT_DIAGNOSTICS_WARNING) {
+        fprintf(stderr, "(libresect) Failed to reparse %s to evaluate macros: %d\n",
+                clang_getCString(filename), error);
+    }
+
+    resect_deallocate(unsaved_files);
+    resect_unsaved_files_free(evaluation_files);
+    resect_deallocate(source);
+    resect_string_free(values);
+    resect_deallocate(evaluation.macros);
+    clang_disposeString(filename);
+}
+
+/**
+ * Macros are evaluated by reparsing the unit, preamble keeps headers it includes from being parsed again.
+ */
+static enum CXTranslationUnit_Flags evaluation_unit_flags(resect_parse_options options) {
+    if (!options->evaluate_macros || options->skip_evaluation) {
+        return 0;
+    }
+    return CXTranslationUnit_PrecompiledPreamble | CXTranslationUnit_CreatePreambleOnFirstParse;
+}
+
+/*
+ * PARALLEL PARSE
+ */
+typedef struct P_resect_parallel_parse {
+    const char *filename;
+    resect_parse_options options;
+
+    // workers parse their own units while the first one shakes, then wait for the context to materialize into
+    resect_mutex lock;
+    resect_condition shaken;
+    resect_translation_context context;
+} *resect_parallel_parse;
+
+typedef struct P_resect_worker {
+    resect_parallel_parse parse;
+
+    CXIndex index;
+    CXTranslationUnit clang_unit;
+
+    struct P_resect_partition partition;
+    // phases of workers overlap with the ones measured by the first worker, so only counters are merged
+    resect_stats stats;
+    bool materialized;
+} *resect_worker;
+
+static void publish_shared_context(resect_parallel_parse parse, resect_translation_context context) {
+    resect_mutex_lock(parse->lock);
+    parse->context = context;
+    resect_condition_broadcast(parse->shaken);
+    resect_mutex_unlock(parse->lock);
+}
+
+static resect_translation_context await_shared_context(resect_parallel_parse parse) {
+    resect_mutex_lock(parse->lock);
+    while (parse->context == NULL) {
+        resect_condition_wait(parse->shaken, parse->lock);
+    }
+    resect_translation_context context = parse->context;
+    resect_mutex_unlock(parse->lock);
+    return context;
+}
+
+static void materialize_partition(resect_worker worker, CXTranslationUnit clang_unit,
+                                  resect_translation_context context) {
+    resect_context_set_stats(context, worker->stats);
+    parse_context(clang_unit, context, worker->stats, &worker->partition);
+    resect_context_set_stats(context, NULL);
+    worker->materialized = true;
+}
+
+static void run_worker(void *data) {
+    resect_worker worker = data;
+    resect_parallel_parse parse = worker->parse;
+
+    // libclang can't be queried from several threads over one translation unit, so every worker parses its own,
+    // diagnostics are reported by the first one
+    worker->index = clang_createIndex(0, 0);
+    worker->clang_unit = create_clang_unit(worker->index, parse->filename, parse->options, 0, worker->stats);
+
+    resect_translation_context shared_context = await_shared_context(parse);
+    if (worker->clang_unit != NULL) {
+        resect_translation_context context = resect_context_create_worker(shared_context, parse->options,
+                                                                          worker->partition.index);
+        materialize_partition(worker, worker->clang_unit, context);
+
+        resect_set deallocated = resect_set_create();
+        resect_context_free(context, deallocated);
+        resect_set_free(deallocated);
+
+        clang_disposeTranslationUnit(worker->clang_unit);
+    }
+    clang_disposeIndex(worker->index);
+}
+
+static resect_translation_unit parse_unit_parallel(const char *filename, resect_parse_options options) {
+    unsigned long long allocated_before = resect_total_allocated_bytes();
+    unsigned int worker_count = options->parallel_workers;
+
+    resect_translation_unit result = resect_allocate(sizeof(struct P_resect_translation_unit));
+    result->stats = resect_stats_create();
+    result->index = NULL;
+    result->clang_unit = NULL;
+    result->options = NULL;
+    result->file_hashes = NULL;
+    result->name_index = NULL;
+    result->sorted_declarations = NULL;
+
+    struct P_resect_parallel_parse parse = {
+        .filename = filename,
+        .options = options,
+        .lock = resect_mutex_create(),
+        .shaken = resect_condition_create(),
+        .context = NULL
+    };
+
+    resect_worker workers = resect_allocate(worker_count * sizeof(struct P_resect_worker));
+    resect_thread *threads = resect_allocate(worker_count * sizeof(resect_thread));
+    for (unsigned int i = 0; i < worker_count; ++i) {
+        resect_worker worker = &workers[i];
+        worker->parse = &parse;
+        worker->index = NULL;
+        worker->clang_unit = NULL;
+        worker->partition.index = i;
+        worker->partition.count = worker_count;
+        worker->partition.ordinal = 0;
+        worker->partition.parse_visit_context = NULL;
+        worker->partition.decl_visit_data = NULL;
+        worker->stats = resect_stats_create();
+        worker->materialized = false;
+    }
+
+    // other workers parse the header on their own meanwhile, the first one runs on the calling thread
+    for (unsigned int i = 1; i < worker_count; ++i) {
+        threads[i] = resect_thread_create(run_worker, &workers[i]);
+    }
+
+    CXIndex index = create_index(options);
+    CXTranslationUnit clang_unit = create_clang_unit(index, filename, options, evaluation_unit_flags(options),
+                                                     result->stats);
+    resect_shaking_context shaking_context = shake_unit(clang_unit, options, result->stats);
+    resect_inclusion_registry inclusion_registry = create_inclusion_registry(shaking_context, result->stats);
+
+    resect_stats_phase_begin(result->stats, RESECT_PHASE_PARSE);
+    resect_translation_context context = resect_context_create_shared(options, inclusion_registry, worker_count);
+    publish_shared_context(&parse, context);
+
+    materialize_partition(&workers[0], clang_unit, context);
+    for (unsigned int i = 1; i < worker_count; ++i) {
+        if (threads[i] != NULL) {
+            resect_thread_join(threads[i]);
+        }
+    }
+    for (unsigned int i = 0; i < worker_count; ++i) {
+        resect_worker worker = &workers[i];
+        // worker couldn't be started or couldn't parse the header, its partition is left to the first unit
+        if (!worker->materialized) {
+            materialize_partition(worker, clang_unit, context);
+        }
+        resect_stats_merge(result->stats, worker->stats);
+        resect_stats_free(worker->stats);
+    }
+
+    result->context = context;
+    result->declarations = resect_create_decl_collection(context);
+    // workers expose decls in whatever order they reach them, location is the order that doesn't depend on that
+    resect_collection_sort(result->declarations, resect_decl_compare_location);
+
+    // shaking graph is kept until now to link dependencies of materialized decls
+    resect_shaking_context_link_dependencies(shaking_context, context);
 
-    resect_translation_unit result = malloc(sizeof(struct P_resect_translation_unit));
-    result->context = translation_context;
-    result->declarations = resect_create_decl_collection(translation_context);
+    evaluate_macros(clang_unit, resect_context_macros(context), options, NULL);
+    resect_context_release_macros(context);
+    resect_stats_phase_end(result->stats, RESECT_PHASE_PARSE);
 
+    resect_stats_phase_begin(result->stats, RESECT_PHASE_TEARDOWN);
+    clang_disposeTranslationUnit(clang_unit);
+    clang_disposeIndex(index);
+    resect_shaking_context_free(shaking_context);
     resect_inclusion_registry_free(inclusion_registry);
+    resect_stats_phase_end(result->stats, RESECT_PHASE_TEARDOWN);
+
+    resect_condition_free(parse.shaken);
+    resect_mutex_free(parse.lock);
+    resect_deallocate(threads);
+    resect_deallocate(workers);
+
+    resect_stats_count(result->stats, RESECT_COUNTER_BYTES_ALLOCATED,
+                       resect_total_allocated_bytes() - allocated_before);
+
+    return result;
+}
+
+static resect_translation_unit parse_unit(const char *filename, resect_parse_options options,
+                                          resect_decl_consumer consumer, void *user_data) {
+    clang_toggleCrashRecovery(false);
+
+    // streamed and reparseable units need a single translation context to report to and to rebuild
+    if (options->parallel_workers > 1 && consumer == NULL && !options->reparseable) {
+        return parse_unit_parallel(filename, options);
+    }
+
+    // allocations from other threads are attributed too, if any are running
+    unsigned long long allocated_before = resect_total_allocated_bytes();
+
+    CXIndex index = create_index(options);
+
+    resect_translation_unit result = resect_allocate(sizeof(struct P_resect_translation_unit));
+    result->stats = resect_stats_create();
+
+    CXTranslationUnit clangUnit = create_clang_unit(index, filename, options, evaluation_unit_flags(options),
+                                                    result->stats);
+
+    // hashed ahead of materialization, which evaluates macros by appending to the main file
+    result->file_hashes = options->reparseable ? hash_unit_files(clangUnit) : NULL;
+    materialize_unit(result, clangUnit, options, consumer, user_data);
+
+    if (options->reparseable) {
+        result->index = index;
+        result->clang_unit = clangUnit;
+        result->options = resect_options_copy(options);
+    } else {
+        resect_stats_phase_begin(result->stats, RESECT_PHASE_TEARDOWN);
+        clang_disposeTranslationUnit(clangUnit);
+        clang_disposeIndex(index);
+        resect_stats_phase_end(result->stats, RESECT_PHASE_TEARDOWN);
+        result->index = NULL;
+        result->clang_unit = NULL;
+        result->options = NULL;
+    }
+
+    resect_stats_count(result->stats, RESECT_COUNTER_BYTES_ALLOCATED,
+                       resect_total_allocated_bytes() - allocated_before);
 
     return result;
 }
 
+resect_translation_unit resect_parse(const char *filename, resect_parse_options options) {
+    return parse_unit(filename, options, NULL, NULL);
+}
+
+resect_translation_unit resect_parse_stream(const char *filename, resect_parse_options options,
+                                            resect_decl_consumer consumer, void *user_data) {
+    return parse_unit(filename, options, consumer, user_data);
+}
+
+resect_bool resect_reparse(resect_translation_unit unit, resect_unsaved_files unsaved_files) {
+    if (unit->clang_unit == NULL) {
+        return resect_false;
+    }
+
+    // files provided in-memory at parse time do not exist on disk and must be supplied again
+    unsigned int unsaved_count = 0;
+    struct CXUnsavedFile *clang_unsaved_files = unsaved_files_to_clang(unsaved_files, unit->options->unsaved_files,
+                                                                       &unsaved_count);
+
+    resect_stats_reset(unit->stats);
+    unsigned long long allocated_before = resect_total_allocated_bytes();
+    resect_stats_phase_begin(unit->stats, RESECT_PHASE_CLANG_PARSE);
+    int error = clang_reparseTranslationUnit(unit->clang_unit, unsaved_count, clang_unsaved_files,
+                                             clang_defaultReparseOptions(unit->clang_unit));
+    resect_stats_phase_end(unit->stats, RESECT_PHASE_CLANG_PARSE);
+    resect_deallocate(clang_unsaved_files);
+
+    if (error != 0) {
+        if (unit->options->diagnostics_level >= RESECT_DIAGNOSTICS_ERROR) {
+            fprintf(stderr, "(libresect) Failed to reparse translation unit: %d\n", error);
+        }
+        // clang requires a translation unit to be disposed after failed reparse,
+        // previously parsed declarations are kept as is
+        clang_disposeTranslationUnit(unit->clang_unit);
+        unit->clang_unit = NULL;
+        return resect_false;
+    }
+
+    // decls of unchanged files are kept, only changed ones and decls referring to them are materialized again
+    resect_table file_hashes = hash_unit_files(unit->clang_unit);
+    resect_table changed_files = find_changed_files(unit->file_hashes, file_hashes);
+    if (resect_table_size(changed_files) > 0) {
+        rematerialize_context(unit, changed_files, unsaved_files);
+
+        release_unit_declaration_collections(unit);
+        collect_unit_declarations(unit, unit->options);
+    }
+    resect_table_free(changed_files, NULL, NULL);
+    free_file_hashes(unit->file_hashes);
+    unit->file_hashes = file_hashes;
+
+    resect_stats_count(unit->stats, RESECT_COUNTER_BYTES_ALLOCATED,
+                       resect_total_allocated_bytes() - allocated_before);
+
+    return resect_true;
+}
+
 void resect_free(resect_translation_unit result) {
-    resect_set deallocated = resect_set_create();
-    resect_context_free(result->context, deallocated);
-    resect_collection_free(result->declarations);
-    resect_set_free(deallocated);
-    free(result);
+    release_unit_declarations(result);
+
+    if (result->clang_unit != NULL) {
+        clang_disposeTranslationUnit(result->clang_unit);
+    }
+    if (result->index != NULL) {
+        clang_disposeIndex(result->index);
+    }
+    if (result->options != NULL) {
+        resect_options_free(result->options);
+    }
+    if (result->file_hashes != NULL) {
+        free_file_hashes(result->file_hashes);
+    }
+    resect_stats_free(result->stats);
+    resect_deallocate(result);
 }
@@ -7,6 +7,46 @@
 #include <clang-c/Index.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+typedef struct P_resect_writer *resect_writer;
+
+typedef struct P_resect_reader *resect_reader;
+
+/*
+ * ALLOCATOR
+ */
+void *resect_allocate(size_t size);
+
+void *resect_reallocate(void *ptr, size_t size);
+
+void resect_deallocate(void *ptr);
+
+/**
+ * @return total number of bytes ever allocated, never decreases
+ */
+unsigned long long resect_total_allocated_bytes();
+
+/*
+ * MEMORY ACCOUNT
+ */
+typedef struct P_resect_memory_account *resect_memory_account;
+
+resect_memory_account resect_memory_account_create();
+
+void resect_memory_account_free(resect_memory_account account);
+
+/**
+ * Makes calling thread charge blocks it allocates, and uncharge blocks of the same account it releases,
+ * to the given account. NULL stops charging.
+ * @return account the thread charged before
+ */
+resect_memory_account resect_memory_account_switch(resect_memory_account account);
+
+/**
+ * @return bytes currently charged to the account
+ */
+unsigned long long resect_memory_account_allocated(resect_memory_account account);
 
 /*
  * STRING
@@ -56,6 +96,8 @@ void *resect_collection_peek_last(resect_collection collection);
 
 unsigned int resect_collection_size(resect_collection collection);
 
+void resect_collection_sort(resect_collection collection, int (*compare)(const void *, const void *));
+
 /*
  * SET
  */
@@ -71,12 +113,35 @@ resect_bool resect_set_contains(resect_set set, void *value);
 
 resect_bool resect_set_add(resect_set set, void *value);
 
+/**
+ * @return false if the value is not in the set
+ */
+resect_bool resect_set_remove(resect_set set, void *value);
+
 void resect_set_remove_all(resect_set set);
 
 void resect_set_add_to_collection(resect_set set, resect_collection collection);
 
 void resect_visit_set(resect_set set, resect_bool (*item_visitor)(void *ctx, void *item), void *context);
 
+/*
+ * POINTER TABLE
+ */
+typedef struct P_resect_pointer_table *resect_pointer_table;
+
+resect_pointer_table resect_pointer_table_create();
+
+resect_bool resect_pointer_table_put_if_absent(resect_pointer_table table, void *key, void *value);
+
+/**
+ * @return NULL when no key found
+ */
+void *resect_pointer_table_get(resect_pointer_table table, void *key);
+
+unsigned int resect_pointer_table_size(resect_pointer_table table);
+
+void resect_pointer_table_free(resect_pointer_table table);
+
 /*
  * HASH TABLE
  */
@@ -105,6 +170,119 @@ void resect_print_table(resect_table table);
 
 void resect_table_free(resect_table table, void (*value_destructor)(void *, void *), void *context);
 
+/*
+ * ATOMICS
+ */
+unsigned int resect_load_acquire(volatile unsigned int *value);
+
+void resect_store_release(volatile unsigned int *value, unsigned int new_value);
+
+/*
+ * MUTEX
+ */
+typedef struct P_resect_mutex *resect_mutex;
+
+resect_mutex resect_mutex_create();
+
+void resect_mutex_lock(resect_mutex mutex);
+
+void resect_mutex_unlock(resect_mutex mutex);
+
+void resect_mutex_free(resect_mutex mutex);
+
+/*
+ * CONDITION
+ */
+typedef struct P_resect_condition *resect_condition;
+
+resect_condition resect_condition_create();
+
+/**
+ * Mutex must be locked by the caller, it is released while waiting and locked again before returning
+ */
+void resect_condition_wait(resect_condition condition, resect_mutex mutex);
+
+void resect_condition_broadcast(resect_condition condition);
+
+void resect_condition_free(resect_condition condition);
+
+/*
+ * CONCURRENT HASH TABLE
+ */
+typedef struct P_resect_concurrent_table *resect_concurrent_table;
+
+/**
+ * @param synchronized false if the table is only ever used by one thread, so shards need no locks
+ */
+resect_concurrent_table resect_concurrent_table_create(bool synchronized);
+
+/**
+ * @return value stored under the key after the call: either the one passed in or the one put by another thread
+ */
+void *resect_concurrent_table_put_if_absent(resect_concurrent_table table, const char *key, void *value);
+
+void *resect_concurrent_table_get(resect_concurrent_table table, const char *key);
+
+bool resect_concurrent_table_remove(resect_concurrent_table table, const char *key);
+
+unsigned int resect_concurrent_table_size(resect_concurrent_table table);
+
+void resect_visit_concurrent_table(resect_concurrent_table table,
+                                   resect_bool (*entry_visitor)(void *, const char *, void *),
+                                   void *context);
+
+void resect_concurrent_table_free(resect_concurrent_table table, void (*value_destructor)(void *, void *),
+                                  void *context);
+
+/*
+ * THREAD
+ */
+typedef struct P_resect_thread *resect_thread;
+
+/**
+ * @return NULL if thread cannot be started
+ */
+resect_thread resect_thread_create(void (*routine)(void *), void *data);
+
+void resect_thread_join(resect_thread thread);
+
+/*
+ * STATS
+ */
+#define RESECT_PHASE_COUNT (RESECT_PHASE_TEARDOWN + 1)
+#define RESECT_COUNTER_COUNT (RESECT_COUNTER_BYTES_ALLOCATED + 1)
+
+typedef struct P_resect_stats *resect_stats;
+
+resect_stats resect_stats_create();
+
+void resect_stats_reset(resect_stats stats);
+
+/**
+ * Phases can be entered several times, measured time accumulates
+ */
+void resect_stats_phase_begin(resect_stats stats, resect_phase phase);
+
+void resect_stats_phase_end(resect_stats stats, resect_phase phase);
+
+/**
+ * @param stats can be NULL, then nothing is counted
+ */
+void resect_stats_count(resect_stats stats, resect_counter counter, unsigned long long amount);
+
+double resect_stats_wall_time(resect_stats stats, resect_phase phase);
+
+double resect_stats_cpu_time(resect_stats stats, resect_phase phase);
+
+unsigned long long resect_stats_counter(resect_stats stats, resect_counter counter);
+
+/**
+ * Adds up counters, phases of parallel workers overlap with the ones measured by the caller, so they are left out
+ */
+void resect_stats_merge(resect_stats stats, resect_stats other);
+
+void resect_stats_free(resect_stats stats);
+
 /*
  * FILTERING
  */
@@ -117,7 +295,7 @@ typedef enum {
 
 typedef struct P_resect_filtering_context *resect_filtering_context;
 
-resect_filtering_context resect_filtering_context_create(resect_parse_options options);
+resect_filtering_context resect_filtering_context_create(resect_parse_options options, resect_stats stats);
 
 void resect_filtering_context_free(resect_filtering_context context);
 
@@ -125,6 +303,26 @@ resect_filter_status resect_filtering_status(resect_filtering_context context,
                                              const char *declaration_name,
                                              const char *declaration_source);
 
+bool resect_filtering_has_roots(resect_filtering_context context);
+
+bool resect_filtering_is_root(resect_filtering_context context, const char *declaration_name);
+
+/*
+ * SYMBOL TABLE
+ */
+typedef struct P_resect_symbol_table *resect_symbol_table;
+
+/**
+ * @return NULL if library cannot be read or has no dynamic symbol table
+ */
+resect_symbol_table resect_symbol_table_load(const char *library_path);
+
+bool resect_symbol_table_contains(resect_symbol_table table, const char *symbol);
+
+unsigned int resect_symbol_table_size(resect_symbol_table table);
+
+void resect_symbol_table_free(resect_symbol_table table);
+
 /*
  * TREE SHAKING
 */
@@ -137,7 +335,7 @@ typedef void (*resect_declaration_visitor)(resect_visit_context ctx, CXCursor cu
 
 typedef struct P_resect_shaking_context *resect_shaking_context;
 
-resect_shaking_context resect_shaking_context_create(resect_parse_options opts);
+resect_shaking_context resect_shaking_context_create(resect_parse_options opts, resect_stats stats);
 
 void resect_shaking_context_free(resect_shaking_context ctx);
 
@@ -163,6 +361,20 @@ enum P_resect_garbage_kind {
 
 resect_translation_context resect_context_create(resect_parse_options opts, resect_inclusion_registry registry);
 
+/**
+ * Creates context of the first parallel worker, contexts of other workers share its decl and type registries
+ */
+resect_translation_context resect_context_create_shared(resect_parse_options opts,
+                                                        resect_inclusion_registry registry,
+                                                        unsigned int worker_count);
+
+/**
+ * @param worker_index index of the worker, from 1 up to the worker count the shared context was created for
+ */
+resect_translation_context resect_context_create_worker(resect_translation_context context,
+                                                        resect_parse_options opts,
+                                                        unsigned int worker_index);
+
 resect_collection resect_create_decl_collection(resect_translation_context context);
 
 void resect_context_init_printing_policy(resect_translation_context context, CXCursor cursor);
@@ -175,7 +387,76 @@ resect_diagnostics_level resect_context_diagnostics_level(resect_translation_con
 
 void resect_context_free(resect_translation_context context, resect_set deallocated);
 
-void resect_register_decl(resect_translation_context context, resect_string id, resect_decl decl);
+void resect_context_update_symbol_status(resect_translation_context context, resect_symbol_table symbols);
+
+resect_collection resect_context_registered_decls(resect_translation_context context);
+
+resect_decl resect_context_find_registered_decl(resect_translation_context context, const char *decl_id);
+
+/**
+ * Carries edges of the shaking decl graph over to registered decls
+ */
+void resect_shaking_context_link_dependencies(resect_shaking_context shaking_context,
+                                              resect_translation_context context);
+
+void resect_context_set_stats(resect_translation_context context, resect_stats stats);
+
+resect_stats resect_context_stats(resect_translation_context context);
+
+/**
+ * @return account charged while this context materializes decls, NULL if no memory limit is set
+ */
+resect_memory_account resect_context_memory_account(resect_translation_context context);
+
+/**
+ * @return true if memory charged to the context is close to the limit set in options
+ */
+bool resect_context_memory_exhausted(resect_translation_context context);
+
+void resect_context_enter_template_arguments(resect_translation_context context);
+
+void resect_context_leave_template_arguments(resect_translation_context context);
+
+bool resect_context_template_depth_exceeded(resect_translation_context context);
+
+void resect_context_enter_pointee(resect_translation_context context);
+
+void resect_context_leave_pointee(resect_translation_context context);
+
+unsigned int resect_context_suspend_pointee(resect_translation_context context);
+
+void resect_context_resume_pointee(resect_translation_context context, unsigned int depth);
+
+bool resect_context_opaque_pointee(resect_translation_context context);
+
+bool resect_context_public_only(resect_translation_context context);
+
+bool resect_context_skip_evaluation(resect_translation_context context);
+
+bool resect_context_evaluate_macros(resect_translation_context context);
+
+bool resect_context_specialization_limit_reached(resect_translation_context context,
+                                                 unsigned int specialization_count);
+
+void resect_context_set_decl_consumer(resect_translation_context context, resect_decl_consumer consumer,
+                                      void *user_data);
+
+void resect_context_enter_decl(resect_translation_context context);
+
+void resect_context_leave_decl(resect_translation_context context);
+
+/**
+ * @return decl registered under the id, which is not the one passed in if another worker registered it first
+ */
+resect_decl resect_register_decl(resect_translation_context context, resect_string id, resect_decl decl);
+
+/**
+ * Registers type that has a declaration, so every worker sharing the registry finds the same one
+ * @return type registered under the key, which is not the one passed in if another worker registered it first
+ */
+resect_type resect_register_declared_type(resect_translation_context context, resect_string key, resect_type type);
+
+resect_type resect_find_declared_type(resect_translation_context context, resect_string key);
 
 bool resect_register_type(resect_translation_context context, CXType clang_type, resect_type resect_type);
 
@@ -185,8 +466,31 @@ resect_language resect_get_assumed_language(resect_translation_context context);
 
 bool resect_is_decl_included(resect_translation_context context, resect_string decl_id);
 
+/**
+ * Inclusion registry is freed along with the shaking context it's created from, so context materializing decls
+ * again after a reparse needs the new one
+ */
+void resect_context_set_inclusion_registry(resect_translation_context context,
+                                          resect_inclusion_registry inclusion_registry);
+
+/**
+ * Drops registered decls located in changed files or no longer included, along with their parts, decls referring
+ * to them and their declared types, so materializing the unit again rebuilds only those and finds the rest as is.
+ * Dropped decls and types are kept as garbage until the context is freed.
+ *
+ * @param changed_files names of changed files as keys
+ * @return number of dropped decls
+ */
+unsigned int resect_context_invalidate(resect_translation_context context, resect_table changed_files);
+
 void resect_expose_decl(resect_translation_context context, resect_decl decl);
 
+void resect_context_add_macro(resect_translation_context context, resect_decl macro);
+
+resect_collection resect_context_macros(resect_translation_context context);
+
+void resect_context_release_macros(resect_translation_context context);
+
 resect_decl resect_find_decl(resect_translation_context context, resect_string decl_id);
 
 resect_type resect_find_type(resect_translation_context context, CXType clang_type);
@@ -197,9 +501,47 @@ resect_decl resect_find_template_parameter(resect_translation_context context, r
 
 void resect_register_garbage(resect_translation_context context, enum P_resect_garbage_kind kind, void *garbage);
 
+/**
+ * Locks registry shared between workers, no-op if the registry isn't shared
+ */
+void resect_context_lock(resect_translation_context context);
+
+void resect_context_unlock(resect_translation_context context);
+
 void resect_context_flush_template_parameters(resect_translation_context context);
 
-resect_visit_context resect_visit_context_create(resect_declaration_visitor visitor);
+/*
+ * BUILD OWNERSHIP
+ */
+typedef enum {
+    // another worker builds it while waiting on this one, so it's used as is, same as a decl referencing itself
+    RESECT_BUILD_BUSY,
+    // this worker builds it further up the stack
+    RESECT_BUILD_OWNED,
+    // this worker builds it from now on, until resect_context_end_build()
+    RESECT_BUILD_CLAIMED
+} resect_build_claim;
+
+/**
+ * Marks registered decl or type as being built by the worker, so other workers wait for it to be complete.
+ * Must be called before it's registered.
+ */
+void resect_context_begin_build(resect_translation_context context, volatile unsigned int *builder);
+
+void resect_context_end_build(resect_translation_context context, volatile unsigned int *builder);
+
+/**
+ * Waits until no other worker builds the decl or type.
+ * @return false if it's still being built by another worker, which waits on this one in turn
+ */
+bool resect_context_await_build(resect_translation_context context, volatile unsigned int *builder);
+
+/**
+ * Waits until no other worker builds the decl or type and claims it to complete something left out before.
+ */
+resect_build_claim resect_context_claim_build(resect_translation_context context, volatile unsigned int *builder);
+
+resect_visit_context resect_visit_context_create(resect_declaration_visitor visitor, resect_stats stats);
 
 void resect_visit_context_free(resect_visit_context ctx);
 
@@ -229,6 +571,8 @@ resect_type_field resect_field_create(resect_visit_context visit_context, resect
 
 void resect_field_collection_free(resect_collection fields, resect_set deallocated);
 
+void resect_type_field_index_free(resect_type type);
+
 resect_type_kind convert_type_kind(enum CXTypeKind kind);
 
 resect_type_category get_type_category(resect_type_kind kind);
@@ -239,6 +583,12 @@ resect_string resect_string_fqn_from_type(resect_translation_context context, CX
 
 resect_string resect_string_fqn_from_type_by_cursor(CXCursor cursor, CXType type, bool strip_elaborated);
 
+resect_type resect_type_allocate();
+
+void resect_type_serialize(resect_type type, resect_writer writer, uint32_t *record);
+
+void resect_type_deserialize(resect_type type, resect_reader reader, const uint32_t *record);
+
 /*
  * DECLARATION
  */
@@ -260,6 +610,21 @@ void resect_decl_free(resect_decl decl, resect_set deallocated);
 
 void resect_decl_collection_free(resect_collection decls, resect_set deallocated);
 
+void resect_decl_update_symbol_status(resect_decl decl, resect_symbol_table symbols);
+
+int resect_decl_compare_location(const void *this, const void *that);
+
+/**
+ * @return namespace and enclosing records joined with "::" ahead of decl name
+ */
+resect_string resect_decl_qualified_name(resect_decl decl);
+
+resect_decl resect_decl_allocate();
+
+void resect_decl_serialize(resect_decl decl, resect_writer writer, uint32_t *record);
+
+void resect_decl_deserialize(resect_decl decl, resect_reader reader, const uint32_t *record);
+
 resect_string resect_location_to_string(resect_location location);
 
 resect_string resect_format_cursor_namespace(CXCursor cursor);
@@ -272,10 +637,41 @@ resect_string resect_extract_decl_id(CXCursor cursor);
 
 void resect_decl_register_specialization(resect_decl decl, resect_type specialization);
 
+unsigned int resect_decl_specialization_count(resect_decl decl);
+
+void resect_decl_unregister_specialization(resect_decl decl, resect_type specialization);
+
+void resect_decl_add_dependency(resect_decl decl, resect_decl dependency);
+
+/**
+ * Removes every dependency and dependent edge of the decl
+ */
+void resect_decl_unlink_dependencies(resect_decl decl);
+
+/**
+ * Collects decls materialized only along with the decl: template parameters, members, parameters and constants
+ */
+void resect_decl_collect_parts(resect_decl decl, resect_collection parts);
+
+/**
+ * @return true if the decl's owner, template, dependency or declaration of a template argument is in the set
+ */
+bool resect_decl_refers_to_any(resect_decl decl, resect_set decls);
+
+resect_collection resect_decl_sort_by_dependencies(resect_collection decls);
+
+void resect_decl_group_collection_free(resect_collection groups);
+
 resect_bool resect_is_forward_declaration(CXCursor cursor);
 
 resect_bool resect_is_specialized(CXCursor cursor);
 
+resect_bool resect_is_public_member(CXCursor cursor);
+
+const char *resect_macro_body(resect_decl decl);
+
+void resect_macro_evaluate(resect_decl decl, CXEvalResult value);
+
 resect_decl_kind convert_cursor_kind(CXCursor cursor);
 
 bool is_cursor_anonymous(CXCursor cursor);
@@ -300,6 +696,131 @@ void resect_template_argument_collection_free(resect_collection args, resect_set
 
 resect_template_argument_kind convert_template_argument_kind(enum CXTemplateArgumentKind kind);
 
+uint32_t resect_template_argument_collection_serialize(resect_collection args, resect_writer writer);
+
+void resect_template_argument_collection_deserialize(resect_collection args, resect_reader reader,
+                                                     uint32_t first, uint32_t count);
+
+
+/*
+ * SERIALIZATION
+ */
+#define RESECT_SERIALIZATION_VERSION (4)
+#define RESECT_NO_REF (0xFFFFFFFFu)
+
+#define RESECT_LOW_BITS(value) ((uint32_t) ((uint64_t) (value) & 0xFFFFFFFFu))
+#define RESECT_HIGH_BITS(value) ((uint32_t) ((uint64_t) (value) >> 32u))
+#define RESECT_JOIN_BITS(low, high) (((uint64_t) (high) << 32u) | (uint64_t) (low))
+
+enum P_resect_decl_record_slot {
+    RESECT_DECL_RECORD_KIND,
+    RESECT_DECL_RECORD_ID,
+    RESECT_DECL_RECORD_NAME,
+    RESECT_DECL_RECORD_NAMESPACE,
+    RESECT_DECL_RECORD_MANGLED_NAME,
+    RESECT_DECL_RECORD_COMMENT,
+    RESECT_DECL_RECORD_SOURCE,
+    RESECT_DECL_RECORD_LOCATION_NAME,
+    RESECT_DECL_RECORD_LOCATION_LINE,
+    RESECT_DECL_RECORD_LOCATION_COLUMN,
+    RESECT_DECL_RECORD_ACCESS,
+    RESECT_DECL_RECORD_LINKAGE,
+    RESECT_DECL_RECORD_FLAGS,
+    RESECT_DECL_RECORD_SYMBOL_STATUS,
+    RESECT_DECL_RECORD_TEMPLATE,
+    RESECT_DECL_RECORD_OWNER,
+    RESECT_DECL_RECORD_TYPE,
+    RESECT_DECL_RECORD_TEMPLATE_PARAMETERS,
+    RESECT_DECL_RECORD_TEMPLATE_PARAMETER_COUNT,
+    RESECT_DECL_RECORD_TEMPLATE_ARGUMENTS,
+    RESECT_DECL_RECORD_TEMPLATE_ARGUMENT_COUNT,
+    RESECT_DECL_RECORD_SPECIALIZATIONS,
+    RESECT_DECL_RECORD_SPECIALIZATION_COUNT,
+    RESECT_DECL_RECORD_DEPENDENCIES,
+    RESECT_DECL_RECORD_DEPENDENCY_COUNT,
+    RESECT_DECL_RECORD_DEPENDENTS,
+    RESECT_DECL_RECORD_DEPENDENT_COUNT,
+    RESECT_DECL_RECORD_DATA,
+    RESECT_DECL_RECORD_SIZE
+};
+
+enum P_resect_decl_record_flag {
+    RESECT_DECL_RECORD_FLAG_TEMPLATE = 1u << 0u,
+    RESECT_DECL_RECORD_FLAG_PARTIAL = 1u << 1u,
+    RESECT_DECL_RECORD_FLAG_FORWARD = 1u << 2u,
+};
+
+enum P_resect_type_record_slot {
+    RESECT_TYPE_RECORD_KIND,
+    RESECT_TYPE_RECORD_NAME,
+    RESECT_TYPE_RECORD_SIZEOF_LOW,
+    RESECT_TYPE_RECORD_SIZEOF_HIGH,
+    RESECT_TYPE_RECORD_ALIGNOF_LOW,
+    RESECT_TYPE_RECORD_ALIGNOF_HIGH,
+    RESECT_TYPE_RECORD_CATEGORY,
+    RESECT_TYPE_RECORD_FLAGS,
+    RESECT_TYPE_RECORD_DECL,
+    RESECT_TYPE_RECORD_FIELDS,
+    RESECT_TYPE_RECORD_FIELD_COUNT,
+    RESECT_TYPE_RECORD_BASE_CLASSES,
+    RESECT_TYPE_RECORD_BASE_CLASS_COUNT,
+    RESECT_TYPE_RECORD_METHODS,
+    RESECT_TYPE_RECORD_METHOD_COUNT,
+    RESECT_TYPE_RECORD_TEMPLATE_ARGUMENTS,
+    RESECT_TYPE_RECORD_TEMPLATE_ARGUMENT_COUNT,
+    RESECT_TYPE_RECORD_DATA,
+    RESECT_TYPE_RECORD_SIZE
+};
+
+enum P_resect_type_record_flag {
+    RESECT_TYPE_RECORD_FLAG_CONST_QUALIFIED = 1u << 0u,
+    RESECT_TYPE_RECORD_FLAG_POD = 1u << 1u,
+    RESECT_TYPE_RECORD_FLAG_UNDECLARED = 1u << 2u,
+    RESECT_TYPE_RECORD_FLAG_TRUNCATED = 1u << 3u,
+    RESECT_TYPE_RECORD_FLAG_OPAQUE = 1u << 4u,
+};
+
+/**
+ * @return false if unit cannot be written to the path
+ */
+bool resect_serialize(resect_translation_context context, resect_collection declarations, const char *path);
+
+/**
+ * @return NULL if file cannot be read or is not a valid serialized unit
+ */
+resect_translation_context resect_deserialize(const char *path);
+
+uint32_t resect_writer_string(resect_writer writer, resect_string string);
+
+uint32_t resect_writer_decl(resect_writer writer, resect_decl decl);
+
+uint32_t resect_writer_type(resect_writer writer, resect_type type);
+
+/**
+ * @return pool offset of the first written value
+ */
+uint32_t resect_writer_block(resect_writer writer, const uint32_t *values, uint32_t count);
+
+uint32_t resect_writer_decl_collection(resect_writer writer, resect_collection decls);
+
+uint32_t resect_writer_type_collection(resect_writer writer, resect_collection types);
+
+resect_string resect_reader_string(resect_reader reader, uint32_t ref);
+
+resect_decl resect_reader_decl(resect_reader reader, uint32_t ref);
+
+resect_type resect_reader_type(resect_reader reader, uint32_t ref);
+
+uint32_t resect_reader_value(resect_reader reader, uint32_t offset);
+
+/**
+ * Marks reader as failed if pool doesn't contain requested range
+ */
+bool resect_reader_check_range(resect_reader reader, uint32_t first, uint64_t length);
+
+void resect_reader_decl_collection(resect_reader reader, uint32_t first, uint32_t count, resect_collection out);
+
+void resect_reader_type_collection(resect_reader reader, uint32_t first, uint32_t count, resect_collection out);
 
 /*
  * UTIL
@@ -314,6 +835,25 @@ resect_string resect_format_cursor_source(CXCursor cursor);
 
 unsigned long resect_hash(const char *str);
 
+unsigned long long resect_hash_buffer(const void *data, size_t length);
+
+/*
+ * FILE MAPPING
+ */
+typedef struct P_resect_file_mapping *resect_file_mapping;
+
+/**
+ * Maps whole file read-only into memory
+ * @return NULL if file cannot be opened, is empty or cannot be mapped
+ */
+resect_file_mapping resect_file_mapping_open(const char *path);
+
+const void *resect_file_mapping_data(resect_file_mapping mapping);
+
+size_t resect_file_mapping_size(resect_file_mapping mapping);
+
+void resect_file_mapping_close(resect_file_mapping mapping);
+
 
 /*
  * OPTIONS
@@ -334,8 +874,26 @@ resect_collection resect_options_get_ignored_definitions(resect_parse_options op
 
 resect_collection resect_options_get_ignored_sources(resect_parse_options opts);
 
+resect_collection resect_options_get_root_definitions(resect_parse_options opts);
+
+unsigned int resect_options_current_root_hop_limit(resect_parse_options opts);
+
 resect_diagnostics_level resect_options_current_diagnostics_level(resect_parse_options opts);
 
+unsigned long long resect_options_current_memory_limit(resect_parse_options opts);
+
+unsigned int resect_options_current_template_depth_limit(resect_parse_options opts);
+
+unsigned int resect_options_current_specialization_limit(resect_parse_options opts);
+
+resect_bool resect_options_current_opaque_through_pointers(resect_parse_options opts);
+
+resect_bool resect_options_current_public_only(resect_parse_options opts);
+
+resect_bool resect_options_current_skip_evaluation(resect_parse_options opts);
+
+resect_bool resect_options_current_evaluate_macros(resect_parse_options opts);
+
 resect_bool convert_bool_from_uint(unsigned int val);
 
 /*
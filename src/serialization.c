@@ -0,0 +1,747 @@
+#include "../resect.h"
+#include "resect_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Serialized unit layout, all values are little-endian 32-bit unsigned integers:
+ *
+ *   header          RESECT_HEADER_SIZE values
+ *   string offsets  string_count values pointing into string blob
+ *   string blob     NUL-terminated strings, padded to 4 bytes
+ *   decl records    decl_count * RESECT_DECL_RECORD_SIZE values
+ *   type records    type_count * RESECT_TYPE_RECORD_SIZE values
+ *   pool            pool_size values holding lists and kind-specific data
+ *
+ * Cross-references are indices into string, decl or type tables, RESECT_NO_REF marks absent reference.
+ */
+#define RESECT_MAGIC "RSCT"
+
+enum P_resect_header_slot {
+    RESECT_HEADER_MAGIC,
+    RESECT_HEADER_VERSION,
+    RESECT_HEADER_LANGUAGE,
+    RESECT_HEADER_STRING_COUNT,
+    RESECT_HEADER_STRING_BLOB_SIZE,
+    RESECT_HEADER_DECL_COUNT,
+    RESECT_HEADER_TYPE_COUNT,
+    RESECT_HEADER_POOL_SIZE,
+    RESECT_HEADER_EXPOSED,
+    RESECT_HEADER_EXPOSED_COUNT,
+    RESECT_HEADER_SIZE
+};
+
+static uint32_t read_u32(const unsigned char *bytes) {
+    return (uint32_t) bytes[0]
+           | (uint32_t) bytes[1] << 8u
+           | (uint32_t) bytes[2] << 16u
+           | (uint32_t) bytes[3] << 24u;
+}
+
+static uint64_t align_to_u32(uint64_t size) {
+    return (size + 3u) & ~(uint64_t) 3u;
+}
+
+/*
+ * BUFFER
+ */
+typedef struct P_resect_buffer {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} resect_buffer;
+
+static void resect_buffer_append(resect_buffer *buffer, const void *data, size_t length) {
+    if (buffer->size + length > buffer->capacity) {
+        size_t new_capacity = buffer->capacity > 0 ? buffer->capacity : 256;
+        while (new_capacity < buffer->size + length) {
+            new_capacity *= 2;
+        }
+        buffer->data = resect_reallocate(buffer->data, new_capacity);
+        buffer->capacity = new_capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, length);
+    buffer->size += length;
+}
+
+static void resect_buffer_append_u32(resect_buffer *buffer, uint32_t value) {
+    unsigned char bytes[4] = {
+        (unsigned char) (value & 0xFFu),
+        (unsigned char) ((value >> 8u) & 0xFFu),
+        (unsigned char) ((value >> 16u) & 0xFFu),
+        (unsigned char) ((value >> 24u) & 0xFFu),
+    };
+    resect_buffer_append(buffer, bytes, sizeof(bytes));
+}
+
+static void resect_buffer_release(resect_buffer *buffer) {
+    resect_deallocate(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
+
+/*
+ * WRITER
+ */
+struct P_resect_writer {
+    resect_table string_table;
+    resect_buffer string_offsets;
+    resect_buffer string_blob;
+    uint32_t string_count;
+
+    resect_pointer_table decl_table;
+    resect_buffer decl_queue;
+    uint32_t decl_count;
+
+    resect_pointer_table type_table;
+    resect_buffer type_queue;
+    uint32_t type_count;
+
+    resect_buffer decl_records;
+    resect_buffer type_records;
+    resect_buffer pool;
+    uint32_t pool_size;
+};
+
+// indices are stored as index + 1 to tell them apart from missing entries
+static void *encode_index(uint32_t index) { return (void *) ((uintptr_t) index + 1); }
+
+static uint32_t decode_index(void *value) { return (uint32_t) ((uintptr_t) value - 1); }
+
+uint32_t resect_writer_string(resect_writer writer, resect_string string) {
+    if (string == NULL) {
+        return RESECT_NO_REF;
+    }
+
+    const char *value = resect_string_to_c(string);
+    void *index = resect_table_get(writer->string_table, value);
+    if (index != NULL) {
+        return decode_index(index);
+    }
+
+    uint32_t new_index = writer->string_count++;
+    resect_table_put(writer->string_table, value, encode_index(new_index));
+    resect_buffer_append_u32(&writer->string_offsets, (uint32_t) writer->string_blob.size);
+    resect_buffer_append(&writer->string_blob, value, strlen(value) + 1);
+
+    return new_index;
+}
+
+static uint32_t resect_writer_enqueue(resect_pointer_table table, resect_buffer *queue, uint32_t *count,
+                                      void *object) {
+    if (object == NULL) {
+        return RESECT_NO_REF;
+    }
+
+    void *index = resect_pointer_table_get(table, object);
+    if (index != NULL) {
+        return decode_index(index);
+    }
+
+    uint32_t new_index = (*count)++;
+    resect_pointer_table_put_if_absent(table, object, encode_index(new_index));
+    resect_buffer_append(queue, &object, sizeof(void *));
+
+    return new_index;
+}
+
+uint32_t resect_writer_decl(resect_writer writer, resect_decl decl) {
+    return resect_writer_enqueue(writer->decl_table, &writer->decl_queue, &writer->decl_count, decl);
+}
+
+uint32_t resect_writer_type(resect_writer writer, resect_type type) {
+    return resect_writer_enqueue(writer->type_table, &writer->type_queue, &writer->type_count, type);
+}
+
+uint32_t resect_writer_block(resect_writer writer, const uint32_t *values, uint32_t count) {
+    uint32_t offset = writer->pool_size;
+    for (uint32_t i = 0; i < count; ++i) {
+        resect_buffer_append_u32(&writer->pool, values[i]);
+    }
+    writer->pool_size += count;
+    return offset;
+}
+
+static uint32_t resect_writer_collection(resect_writer writer, resect_collection collection,
+                                         uint32_t (*write_ref)(resect_writer, void *)) {
+    unsigned int count = resect_collection_size(collection);
+    if (count == 0) {
+        return writer->pool_size;
+    }
+
+    uint32_t *refs = resect_allocate(count * sizeof(uint32_t));
+    unsigned int i = 0;
+    resect_iterator iter = resect_collection_iterator(collection);
+    while (resect_iterator_next(iter)) {
+        refs[i++] = write_ref(writer, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+
+    uint32_t offset = resect_writer_block(writer, refs, count);
+    resect_deallocate(refs);
+    return offset;
+}
+
+static uint32_t write_decl_ref(resect_writer writer, void *decl) { return resect_writer_decl(writer, decl); }
+
+static uint32_t write_type_ref(resect_writer writer, void *type) { return resect_writer_type(writer, type); }
+
+uint32_t resect_writer_decl_collection(resect_writer writer, resect_collection decls) {
+    return resect_writer_collection(writer, decls, write_decl_ref);
+}
+
+uint32_t resect_writer_type_collection(resect_writer writer, resect_collection types) {
+    return resect_writer_collection(writer, types, write_type_ref);
+}
+
+static void resect_writer_init(resect_writer writer) {
+    memset(writer, 0, sizeof(struct P_resect_writer));
+    writer->string_table = resect_table_create();
+    writer->decl_table = resect_pointer_table_create();
+    writer->type_table = resect_pointer_table_create();
+}
+
+static void resect_writer_release(resect_writer writer) {
+    resect_table_free(writer->string_table, NULL, NULL);
+    resect_pointer_table_free(writer->decl_table);
+    resect_pointer_table_free(writer->type_table);
+
+    resect_buffer_release(&writer->string_offsets);
+    resect_buffer_release(&writer->string_blob);
+    resect_buffer_release(&writer->decl_queue);
+    resect_buffer_release(&writer->type_queue);
+    resect_buffer_release(&writer->decl_records);
+    resect_buffer_release(&writer->type_records);
+    resect_buffer_release(&writer->pool);
+}
+
+static void resect_writer_flush_records(resect_writer writer) {
+    uint32_t decls_written = 0;
+    uint32_t types_written = 0;
+
+    // serializing a record discovers new decls and types, so loop until both queues are drained
+    while (decls_written < writer->decl_count || types_written < writer->type_count) {
+        while (decls_written < writer->decl_count) {
+            resect_decl decl = ((resect_decl *) writer->decl_queue.data)[decls_written++];
+
+            uint32_t record[RESECT_DECL_RECORD_SIZE];
+            resect_decl_serialize(decl, writer, record);
+            for (int i = 0; i < RESECT_DECL_RECORD_SIZE; ++i) {
+                resect_buffer_append_u32(&writer->decl_records, record[i]);
+            }
+        }
+
+        while (types_written < writer->type_count) {
+            resect_type type = ((resect_type *) writer->type_queue.data)[types_written++];
+
+            uint32_t record[RESECT_TYPE_RECORD_SIZE];
+            resect_type_serialize(type, writer, record);
+            for (int i = 0; i < RESECT_TYPE_RECORD_SIZE; ++i) {
+                resect_buffer_append_u32(&writer->type_records, record[i]);
+            }
+        }
+    }
+}
+
+static bool resect_writer_dump(resect_writer writer, resect_language language,
+                               uint32_t exposed, uint32_t exposed_count, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    resect_buffer header = {0};
+    resect_buffer_append(&header, RESECT_MAGIC, 4);
+    resect_buffer_append_u32(&header, RESECT_SERIALIZATION_VERSION);
+    resect_buffer_append_u32(&header, (uint32_t) language);
+    resect_buffer_append_u32(&header, writer->string_count);
+    resect_buffer_append_u32(&header, (uint32_t) writer->string_blob.size);
+    resect_buffer_append_u32(&header, writer->decl_count);
+    resect_buffer_append_u32(&header, writer->type_count);
+    resect_buffer_append_u32(&header, writer->pool_size);
+    resect_buffer_append_u32(&header, exposed);
+    resect_buffer_append_u32(&header, exposed_count);
+
+    static const unsigned char padding[4] = {0};
+    size_t padding_size = align_to_u32(writer->string_blob.size) - writer->string_blob.size;
+
+    bool result = fwrite(header.data, 1, header.size, file) == header.size
+                  && fwrite(writer->string_offsets.data, 1, writer->string_offsets.size, file)
+                     == writer->string_offsets.size
+                  && fwrite(writer->string_blob.data, 1, writer->string_blob.size, file) == writer->string_blob.size
+                  && fwrite(padding, 1, padding_size, file) == padding_size
+                  && fwrite(writer->decl_records.data, 1, writer->decl_records.size, file)
+                     == writer->decl_records.size
+                  && fwrite(writer->type_records.data, 1, writer->type_records.size, file)
+                     == writer->type_records.size
+                  && fwrite(writer->pool.data, 1, writer->pool.size, file) == writer->pool.size;
+
+    resect_buffer_release(&header);
+    if (fclose(file) != 0) {
+        result = false;
+    }
+
+    return result;
+}
+
+bool resect_serialize(resect_translation_context context, resect_collection declarations, const char *path) {
+    struct P_resect_writer writer;
+    resect_writer_init(&writer);
+
+    // every registered decl is owned by the unit, not only exposed ones
+    resect_collection registered_decls = resect_context_registered_decls(context);
+    resect_writer_decl_collection(&writer, registered_decls);
+    resect_collection_free(registered_decls);
+
+    uint32_t exposed = resect_writer_decl_collection(&writer, declarations);
+    uint32_t exposed_count = resect_collection_size(declarations);
+
+    resect_writer_flush_records(&writer);
+
+    bool result = resect_writer_dump(&writer, resect_get_assumed_language(context), exposed, exposed_count, path);
+
+    resect_writer_release(&writer);
+    return result;
+}
+
+/*
+ * READER
+ */
+struct P_resect_reader {
+    uint32_t language;
+
+    uint32_t string_count;
+    const unsigned char *string_offsets;
+    const char *string_blob;
+    uint32_t string_blob_size;
+
+    uint32_t decl_count;
+    const unsigned char *decl_records;
+    resect_decl *decls;
+
+    uint32_t type_count;
+    const unsigned char *type_records;
+    resect_type *types;
+
+    uint32_t pool_size;
+    const unsigned char *pool;
+
+    uint32_t exposed;
+    uint32_t exposed_count;
+
+    bool failed;
+};
+
+static bool resect_reader_init(resect_reader reader, const unsigned char *data, size_t size) {
+    memset(reader, 0, sizeof(struct P_resect_reader));
+
+    uint64_t header_size = RESECT_HEADER_SIZE * sizeof(uint32_t);
+    if (size < header_size || memcmp(data, RESECT_MAGIC, 4) != 0
+        || read_u32(data + 4 * RESECT_HEADER_VERSION) != RESECT_SERIALIZATION_VERSION) {
+        return false;
+    }
+
+    reader->language = read_u32(data + 4 * RESECT_HEADER_LANGUAGE);
+    reader->string_count = read_u32(data + 4 * RESECT_HEADER_STRING_COUNT);
+    reader->string_blob_size = read_u32(data + 4 * RESECT_HEADER_STRING_BLOB_SIZE);
+    reader->decl_count = read_u32(data + 4 * RESECT_HEADER_DECL_COUNT);
+    reader->type_count = read_u32(data + 4 * RESECT_HEADER_TYPE_COUNT);
+    reader->pool_size = read_u32(data + 4 * RESECT_HEADER_POOL_SIZE);
+    reader->exposed = read_u32(data + 4 * RESECT_HEADER_EXPOSED);
+    reader->exposed_count = read_u32(data + 4 * RESECT_HEADER_EXPOSED_COUNT);
+
+    uint64_t offset = header_size;
+
+    reader->string_offsets = data + offset;
+    offset += (uint64_t) reader->string_count * sizeof(uint32_t);
+
+    reader->string_blob = (const char *) data + offset;
+    offset += align_to_u32(reader->string_blob_size);
+
+    reader->decl_records = data + offset;
+    offset += (uint64_t) reader->decl_count * RESECT_DECL_RECORD_SIZE * sizeof(uint32_t);
+
+    reader->type_records = data + offset;
+    offset += (uint64_t) reader->type_count * RESECT_TYPE_RECORD_SIZE * sizeof(uint32_t);
+
+    reader->pool = data + offset;
+    offset += (uint64_t) reader->pool_size * sizeof(uint32_t);
+
+    if (offset > size) {
+        return false;
+    }
+
+    // terminated blob guarantees any in-bounds string offset yields terminated string
+    return reader->string_blob_size == 0 || reader->string_blob[reader->string_blob_size - 1] == '\0';
+}
+
+bool resect_reader_check_range(resect_reader reader, uint32_t first, uint64_t length) {
+    if ((uint64_t) first + length > reader->pool_size) {
+        reader->failed = true;
+        return false;
+    }
+    return true;
+}
+
+resect_string resect_reader_string(resect_reader reader, uint32_t ref) {
+    if (ref == RESECT_NO_REF) {
+        return resect_string_from_c("");
+    }
+
+    if (ref >= reader->string_count) {
+        reader->failed = true;
+        return resect_string_from_c("");
+    }
+
+    uint32_t offset = read_u32(reader->string_offsets + 4 * (uint64_t) ref);
+    if (offset >= reader->string_blob_size
+        || memchr(reader->string_blob + offset, '\0', reader->string_blob_size - offset) == NULL) {
+        reader->failed = true;
+        return resect_string_from_c("");
+    }
+
+    return resect_string_from_c(reader->string_blob + offset);
+}
+
+resect_decl resect_reader_decl(resect_reader reader, uint32_t ref) {
+    if (ref == RESECT_NO_REF) {
+        return NULL;
+    }
+    if (ref >= reader->decl_count) {
+        reader->failed = true;
+        return NULL;
+    }
+    return reader->decls[ref];
+}
+
+resect_type resect_reader_type(resect_reader reader, uint32_t ref) {
+    if (ref == RESECT_NO_REF) {
+        return NULL;
+    }
+    if (ref >= reader->type_count) {
+        reader->failed = true;
+        return NULL;
+    }
+    return reader->types[ref];
+}
+
+uint32_t resect_reader_value(resect_reader reader, uint32_t offset) {
+    if (offset >= reader->pool_size) {
+        reader->failed = true;
+        return 0;
+    }
+    return read_u32(reader->pool + 4 * (uint64_t) offset);
+}
+
+void resect_reader_decl_collection(resect_reader reader, uint32_t first, uint32_t count, resect_collection out) {
+    if (!resect_reader_check_range(reader, first, count)) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        resect_decl decl = resect_reader_decl(reader, resect_reader_value(reader, first + i));
+        if (decl != NULL) {
+            resect_collection_add(out, decl);
+        }
+    }
+}
+
+void resect_reader_type_collection(resect_reader reader, uint32_t first, uint32_t count, resect_collection out) {
+    if (!resect_reader_check_range(reader, first, count)) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        resect_type type = resect_reader_type(reader, resect_reader_value(reader, first + i));
+        if (type != NULL) {
+            resect_collection_add(out, type);
+        }
+    }
+}
+
+static void read_record(const unsigned char *records, uint32_t index, uint32_t *record, int record_size) {
+    const unsigned char *start = records + (uint64_t) index * record_size * sizeof(uint32_t);
+    for (int i = 0; i < record_size; ++i) {
+        record[i] = read_u32(start + 4 * i);
+    }
+}
+
+static void resect_reader_populate(resect_reader reader, resect_translation_context context) {
+    for (uint32_t i = 0; i < reader->decl_count; ++i) {
+        uint32_t record[RESECT_DECL_RECORD_SIZE];
+        read_record(reader->decl_records, i, record, RESECT_DECL_RECORD_SIZE);
+
+        resect_decl decl = reader->decls[i];
+        resect_decl_deserialize(decl, reader, record);
+
+        // garbage owns every decl even if malformed input has duplicate ids
+        resect_register_garbage(context, RESECT_GARBAGE_KIND_DECL, decl);
+        resect_string decl_id = resect_string_from_c(resect_decl_get_id(decl));
+        resect_register_decl(context, decl_id, decl);
+        resect_string_free(decl_id);
+    }
+
+    for (uint32_t i = 0; i < reader->type_count; ++i) {
+        uint32_t record[RESECT_TYPE_RECORD_SIZE];
+        read_record(reader->type_records, i, record, RESECT_TYPE_RECORD_SIZE);
+
+        resect_type type = reader->types[i];
+        resect_type_deserialize(type, reader, record);
+        resect_register_garbage(context, RESECT_GARBAGE_KIND_TYPE, type);
+    }
+
+    resect_collection exposed = resect_collection_create();
+    resect_reader_decl_collection(reader, reader->exposed, reader->exposed_count, exposed);
+
+    resect_iterator iter = resect_collection_iterator(exposed);
+    while (resect_iterator_next(iter)) {
+        resect_expose_decl(context, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+    resect_collection_free(exposed);
+}
+
+resect_translation_context resect_deserialize(const char *path) {
+    resect_file_mapping mapping = resect_file_mapping_open(path);
+    if (mapping == NULL) {
+        return NULL;
+    }
+
+    struct P_resect_reader reader;
+    if (!resect_reader_init(&reader, resect_file_mapping_data(mapping), resect_file_mapping_size(mapping))) {
+        resect_file_mapping_close(mapping);
+        return NULL;
+    }
+
+    resect_translation_context context = resect_context_create(NULL, NULL);
+    resect_register_decl_language(context, (resect_language) reader.language);
+
+    // all objects are allocated upfront, so records can reference each other in any order
+    reader.decls = resect_allocate(reader.decl_count * sizeof(resect_decl) + 1);
+    for (uint32_t i = 0; i < reader.decl_count; ++i) {
+        reader.decls[i] = resect_decl_allocate();
+    }
+
+    reader.types = resect_allocate(reader.type_count * sizeof(resect_type) + 1);
+    for (uint32_t i = 0; i < reader.type_count; ++i) {
+        reader.types[i] = resect_type_allocate();
+    }
+
+    resect_reader_populate(&reader, context);
+
+    resect_deallocate(reader.decls);
+    resect_deallocate(reader.types);
+    resect_file_mapping_close(mapping);
+
+    if (reader.failed) {
+        resect_set deallocated = resect_set_create();
+        resect_context_free(context, deallocated);
+        resect_set_free(deallocated);
+        return NULL;
+    }
+
+    return context;
+}
+
+/*
+ * MAPPED UNIT
+ */
+struct P_resect_mapped_unit {
+    resect_file_mapping mapping;
+    struct P_resect_reader reader;
+};
+
+resect_mapped_unit resect_unit_map(const char *path) {
+    resect_file_mapping mapping = resect_file_mapping_open(path);
+    if (mapping == NULL) {
+        return NULL;
+    }
+
+    resect_mapped_unit unit = resect_allocate(sizeof(struct P_resect_mapped_unit));
+    unit->mapping = mapping;
+    if (!resect_reader_init(&unit->reader, resect_file_mapping_data(mapping), resect_file_mapping_size(mapping))) {
+        resect_unit_unmap(unit);
+        return NULL;
+    }
+
+    return unit;
+}
+
+void resect_unit_unmap(resect_mapped_unit unit) {
+    resect_file_mapping_close(unit->mapping);
+    resect_deallocate(unit);
+}
+
+static const char *mapped_string(resect_mapped_unit unit, uint32_t ref) {
+    if (ref >= unit->reader.string_count) {
+        return "";
+    }
+    uint32_t offset = read_u32(unit->reader.string_offsets + 4 * (uint64_t) ref);
+    if (offset >= unit->reader.string_blob_size) {
+        return "";
+    }
+    return unit->reader.string_blob + offset;
+}
+
+static resect_mapped_decl mapped_decl(resect_mapped_unit unit, uint32_t ref) {
+    if (ref >= unit->reader.decl_count) {
+        return NULL;
+    }
+    return (resect_mapped_decl) (unit->reader.decl_records
+                                 + (uint64_t) ref * RESECT_DECL_RECORD_SIZE * sizeof(uint32_t));
+}
+
+static resect_mapped_type mapped_type(resect_mapped_unit unit, uint32_t ref) {
+    if (ref >= unit->reader.type_count) {
+        return NULL;
+    }
+    return (resect_mapped_type) (unit->reader.type_records
+                                 + (uint64_t) ref * RESECT_TYPE_RECORD_SIZE * sizeof(uint32_t));
+}
+
+static uint32_t decl_slot(resect_mapped_decl decl, enum P_resect_decl_record_slot slot) {
+    return read_u32((const unsigned char *) decl + 4 * slot);
+}
+
+static uint32_t type_slot(resect_mapped_type type, enum P_resect_type_record_slot slot) {
+    return read_u32((const unsigned char *) type + 4 * slot);
+}
+
+resect_language resect_mapped_unit_get_language(resect_mapped_unit unit) {
+    return (resect_language) unit->reader.language;
+}
+
+unsigned int resect_mapped_unit_declaration_count(resect_mapped_unit unit) {
+    if ((uint64_t) unit->reader.exposed + unit->reader.exposed_count > unit->reader.pool_size) {
+        return 0;
+    }
+    return unit->reader.exposed_count;
+}
+
+resect_mapped_decl resect_mapped_unit_declaration(resect_mapped_unit unit, unsigned int index) {
+    if (index >= resect_mapped_unit_declaration_count(unit)) {
+        return NULL;
+    }
+    return mapped_decl(unit, read_u32(unit->reader.pool + 4 * ((uint64_t) unit->reader.exposed + index)));
+}
+
+resect_decl_kind resect_mapped_decl_get_kind(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return (resect_decl_kind) decl_slot(decl, RESECT_DECL_RECORD_KIND);
+}
+
+const char *resect_mapped_decl_get_id(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_string(unit, decl_slot(decl, RESECT_DECL_RECORD_ID));
+}
+
+const char *resect_mapped_decl_get_name(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_string(unit, decl_slot(decl, RESECT_DECL_RECORD_NAME));
+}
+
+const char *resect_mapped_decl_get_namespace(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_string(unit, decl_slot(decl, RESECT_DECL_RECORD_NAMESPACE));
+}
+
+const char *resect_mapped_decl_get_mangled_name(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_string(unit, decl_slot(decl, RESECT_DECL_RECORD_MANGLED_NAME));
+}
+
+const char *resect_mapped_decl_get_comment(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_string(unit, decl_slot(decl, RESECT_DECL_RECORD_COMMENT));
+}
+
+const char *resect_mapped_decl_get_source(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_string(unit, decl_slot(decl, RESECT_DECL_RECORD_SOURCE));
+}
+
+const char *resect_mapped_decl_get_location_name(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_string(unit, decl_slot(decl, RESECT_DECL_RECORD_LOCATION_NAME));
+}
+
+unsigned int resect_mapped_decl_get_location_line(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return decl_slot(decl, RESECT_DECL_RECORD_LOCATION_LINE);
+}
+
+unsigned int resect_mapped_decl_get_location_column(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return decl_slot(decl, RESECT_DECL_RECORD_LOCATION_COLUMN);
+}
+
+resect_access_specifier resect_mapped_decl_get_access_specifier(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return (resect_access_specifier) decl_slot(decl, RESECT_DECL_RECORD_ACCESS);
+}
+
+resect_linkage_kind resect_mapped_decl_get_linkage(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return (resect_linkage_kind) decl_slot(decl, RESECT_DECL_RECORD_LINKAGE);
+}
+
+resect_bool resect_mapped_decl_is_template(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return convert_bool_from_uint(decl_slot(decl, RESECT_DECL_RECORD_FLAGS) & RESECT_DECL_RECORD_FLAG_TEMPLATE);
+}
+
+resect_bool resect_mapped_decl_is_forward(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return convert_bool_from_uint(decl_slot(decl, RESECT_DECL_RECORD_FLAGS) & RESECT_DECL_RECORD_FLAG_FORWARD);
+}
+
+resect_symbol_status resect_mapped_decl_get_symbol_status(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return (resect_symbol_status) decl_slot(decl, RESECT_DECL_RECORD_SYMBOL_STATUS);
+}
+
+resect_mapped_decl resect_mapped_decl_get_owner(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_decl(unit, decl_slot(decl, RESECT_DECL_RECORD_OWNER));
+}
+
+resect_mapped_decl resect_mapped_decl_get_template(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_decl(unit, decl_slot(decl, RESECT_DECL_RECORD_TEMPLATE));
+}
+
+resect_mapped_type resect_mapped_decl_get_type(resect_mapped_unit unit, resect_mapped_decl decl) {
+    return mapped_type(unit, decl_slot(decl, RESECT_DECL_RECORD_TYPE));
+}
+
+resect_type_kind resect_mapped_type_get_kind(resect_mapped_unit unit, resect_mapped_type type) {
+    return (resect_type_kind) type_slot(type, RESECT_TYPE_RECORD_KIND);
+}
+
+const char *resect_mapped_type_get_name(resect_mapped_unit unit, resect_mapped_type type) {
+    return mapped_string(unit, type_slot(type, RESECT_TYPE_RECORD_NAME));
+}
+
+long long resect_mapped_type_sizeof(resect_mapped_unit unit, resect_mapped_type type) {
+    return (long long) RESECT_JOIN_BITS(type_slot(type, RESECT_TYPE_RECORD_SIZEOF_LOW),
+                                        type_slot(type, RESECT_TYPE_RECORD_SIZEOF_HIGH));
+}
+
+long long resect_mapped_type_alignof(resect_mapped_unit unit, resect_mapped_type type) {
+    return (long long) RESECT_JOIN_BITS(type_slot(type, RESECT_TYPE_RECORD_ALIGNOF_LOW),
+                                        type_slot(type, RESECT_TYPE_RECORD_ALIGNOF_HIGH));
+}
+
+resect_type_category resect_mapped_type_get_category(resect_mapped_unit unit, resect_mapped_type type) {
+    return (resect_type_category) type_slot(type, RESECT_TYPE_RECORD_CATEGORY);
+}
+
+resect_bool resect_mapped_type_is_const_qualified(resect_mapped_unit unit, resect_mapped_type type) {
+    return convert_bool_from_uint(type_slot(type, RESECT_TYPE_RECORD_FLAGS)
+                                  & RESECT_TYPE_RECORD_FLAG_CONST_QUALIFIED);
+}
+
+resect_bool resect_mapped_type_is_pod(resect_mapped_unit unit, resect_mapped_type type) {
+    return convert_bool_from_uint(type_slot(type, RESECT_TYPE_RECORD_FLAGS) & RESECT_TYPE_RECORD_FLAG_POD);
+}
+
+resect_bool resect_mapped_type_is_undeclared(resect_mapped_unit unit, resect_mapped_type type) {
+    return convert_bool_from_uint(type_slot(type, RESECT_TYPE_RECORD_FLAGS) & RESECT_TYPE_RECORD_FLAG_UNDECLARED);
+}
+
+resect_bool resect_mapped_type_is_truncated(resect_mapped_unit unit, resect_mapped_type type) {
+    return convert_bool_from_uint(type_slot(type, RESECT_TYPE_RECORD_FLAGS) & RESECT_TYPE_RECORD_FLAG_TRUNCATED);
+}
+
+resect_bool resect_mapped_type_is_opaque(resect_mapped_unit unit, resect_mapped_type type) {
+    return convert_bool_from_uint(type_slot(type, RESECT_TYPE_RECORD_FLAGS) & RESECT_TYPE_RECORD_FLAG_OPAQUE);
+}
+
+resect_mapped_decl resect_mapped_type_get_declaration(resect_mapped_unit unit, resect_mapped_type type) {
+    return mapped_decl(unit, type_slot(type, RESECT_TYPE_RECORD_DECL));
+}
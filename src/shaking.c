@@ -19,11 +19,14 @@ typedef struct P_resect_decl_graph_edge {
 
 typedef struct P_resect_decl_graph_node {
     resect_string id;
+    resect_decl_kind kind;
     resect_filter_status filter_status;
     resect_access_level access_level;
+    bool root;
     resect_table /*resect_string*/ parents;
 
     resect_table /*resect_decl_graph_edge*/ edges;
+    resect_table /*resect_decl_graph_node*/ members;
 } *resect_decl_graph_node;
 
 typedef struct P_resect_decl_graph {
@@ -34,26 +37,29 @@ typedef struct P_resect_decl_graph {
 // EDGE
 //
 static resect_decl_graph_edge resect_decl_graph_edge_create(resect_string id) {
-    resect_decl_graph_edge edge = malloc(sizeof(struct P_resect_decl_graph_edge));
+    resect_decl_graph_edge edge = resect_allocate(sizeof(struct P_resect_decl_graph_edge));
     edge->id = resect_string_copy(id);
     return edge;
 }
 
 static void resect_decl_graph_edge_free(resect_decl_graph_edge edge) {
     resect_string_free(edge->id);
-    free(edge);
+    resect_deallocate(edge);
 }
 
 //
 // NODE
 //
 static resect_decl_graph_node resect_decl_graph_node_create(resect_string id) {
-    resect_decl_graph_node node = malloc(sizeof(struct P_resect_decl_graph_node));
+    resect_decl_graph_node node = resect_allocate(sizeof(struct P_resect_decl_graph_node));
     node->id = resect_string_copy(id);
     node->filter_status = RESECT_FILTER_STATUS_IGNORED;
     node->access_level = RESECT_ACCESS_LEVEL_UNKNOWN;
+    node->kind = RESECT_DECL_KIND_UNKNOWN;
+    node->root = false;
     node->parents = resect_table_create();
     node->edges = resect_table_create();
+    node->members = resect_table_create();
     return node;
 }
 
@@ -78,7 +84,8 @@ static void resect_decl_graph_node_free(resect_decl_graph_node node) {
     resect_string_free(node->id);
     resect_table_free(node->parents, NULL, NULL);
     resect_table_free(node->edges, edge_table_value_free, NULL);
-    free(node);
+    resect_table_free(node->members, NULL, NULL);
+    resect_deallocate(node);
 }
 
 static bool resect_decl_graph_node_add_parent(resect_decl_graph_node node, resect_string id) {
@@ -89,23 +96,19 @@ static bool resect_decl_graph_node_add_parent(resect_decl_graph_node node, resec
 // GRAPH
 //
 static resect_decl_graph resect_decl_graph_create() {
-    resect_decl_graph graph = malloc(sizeof(struct P_resect_decl_graph));
+    resect_decl_graph graph = resect_allocate(sizeof(struct P_resect_decl_graph));
     graph->node_table = resect_table_create();
     return graph;
 }
 
-static resect_bool resect_table_node_free(void *context, const char *key, void *node) {
-    resect_decl_graph_node_free(node);
-    return false;
-}
+static void resect_table_node_free(void *context, void *node) { resect_decl_graph_node_free(node); }
 
 static void resect_decl_graph_free(resect_decl_graph graph) {
-    resect_visit_table(graph->node_table, resect_table_node_free, NULL);
-
-    free(graph);
+    resect_table_free(graph->node_table, resect_table_node_free, NULL);
+    resect_deallocate(graph);
 }
 
-static bool resect_decl_graph_add_node(resect_decl_graph graph, resect_string id,
+static bool resect_decl_graph_add_node(resect_decl_graph graph, resect_string id, resect_decl_kind kind,
                                        resect_filter_status filter_status, resect_access_level access_level) {
     const char *key = resect_string_to_c(id);
     // ReSharper disable once CppDFANullDereference
@@ -114,6 +117,7 @@ static bool resect_decl_graph_add_node(resect_decl_graph graph, resect_string id
     }
 
     resect_decl_graph_node node = resect_decl_graph_node_create(id);
+    node->kind = kind;
     node->filter_status = filter_status;
     node->access_level = access_level;
 
@@ -169,13 +173,17 @@ typedef struct P_resect_shaking_context {
     resect_decl_graph decl_graph;
     resect_string root_decl_id;
     resect_collection /*resect_string*/ bound_parents; // reversed edges, not semantic decl parents
+    unsigned int root_hop_limit;
+    bool public_only;
 
     resect_diagnostics_level diagnostics_level;
+    resect_stats stats;
 } *resect_shaking_context;
 
-resect_shaking_context resect_shaking_context_create(resect_parse_options opts) {
-    resect_shaking_context context = malloc(sizeof(struct P_resect_shaking_context));
-    context->filtering = resect_filtering_context_create(opts);
+resect_shaking_context resect_shaking_context_create(resect_parse_options opts, resect_stats stats) {
+    resect_shaking_context context = resect_allocate(sizeof(struct P_resect_shaking_context));
+    context->filtering = resect_filtering_context_create(opts, stats);
+    context->stats = stats;
     context->bound_parents = resect_collection_create();
     context->decl_graph = resect_decl_graph_create();
 
@@ -183,9 +191,11 @@ resect_shaking_context resect_shaking_context_create(resect_parse_options opts)
 
     resect_collection_add(context->bound_parents, resect_string_copy(context->root_decl_id));
 
-    resect_decl_graph_add_node(context->decl_graph, context->root_decl_id,
+    resect_decl_graph_add_node(context->decl_graph, context->root_decl_id, RESECT_DECL_KIND_UNKNOWN,
                                RESECT_FILTER_STATUS_INCLUDED, RESECT_ACCESS_LEVEL_PUBLIC);
 
+    context->root_hop_limit = resect_options_current_root_hop_limit(opts);
+    context->public_only = resect_options_current_public_only(opts);
     context->diagnostics_level = resect_options_current_diagnostics_level(opts);
     return context;
 }
@@ -195,7 +205,7 @@ void resect_shaking_context_free(resect_shaking_context context) {
     resect_string_free(context->root_decl_id);
     resect_string_collection_free(context->bound_parents);
     resect_decl_graph_free(context->decl_graph);
-    free(context);
+    resect_deallocate(context);
 }
 
 void resect_shaking_context_push_decl_link(resect_shaking_context ctx, resect_string decl_id) {
@@ -233,6 +243,18 @@ void resect_decl_shake(resect_visit_context visit_context, CXCursor cursor, void
     resect_investigate_decl(visit_context, shaking_context, cursor);
 }
 
+static bool resect_cursor_is_root(resect_filtering_context filtering, CXCursor cursor) {
+    if (!resect_filtering_has_roots(filtering)) {
+        return false;
+    }
+
+    resect_string full_name = resect_format_cursor_full_name(cursor);
+    bool result = resect_filtering_is_root(filtering, resect_string_to_c(full_name));
+    resect_string_free(full_name);
+
+    return result;
+}
+
 static resect_filter_status resect_cursor_filter_status(resect_filtering_context filtering, CXCursor cursor) {
     resect_string full_name = resect_format_cursor_full_name(cursor);
     resect_string source = resect_format_cursor_source(cursor);
@@ -264,7 +286,7 @@ static void resect_investigate_template_specializations(resect_visit_context vis
                                                         resect_shaking_context context, CXCursor cursor);
 
 static void resect_investigate_owner(resect_visit_context visit_context, resect_shaking_context context,
-                                     CXCursor cursor);
+                                     CXCursor cursor, resect_string decl_id);
 
 static resect_access_level convert_access_level(CXCursor cursor) {
     if (clang_getCursorKind(cursor) == CXCursor_CXXMethod && clang_CXXMethod_isDeleted(cursor)) {
@@ -298,12 +320,18 @@ void resect_investigate_decl(resect_visit_context visit_context, resect_shaking_
     resect_string parent_id = resect_shaking_context_decl_parent_id(shaking_context);
 
     resect_access_level access_level = convert_access_level(cursor);
+    if (shaking_context->public_only && access_level == RESECT_ACCESS_LEVEL_PROTECTED) {
+        // protected members are never materialized, so whatever they depend on is not needed either
+        access_level = RESECT_ACCESS_LEVEL_INACCESSIBLE;
+    }
 
     resect_filter_status filter_status = resect_cursor_filter_status(shaking_context->filtering, cursor);
 
     bool node_existed = resect_decl_graph_has_node(shaking_context->decl_graph, decl_id);
     if (!node_existed) {
-        resect_decl_graph_add_node(shaking_context->decl_graph, decl_id, filter_status, access_level);
+        resect_decl_graph_add_node(shaking_context->decl_graph, decl_id, decl_kind, filter_status, access_level);
+        resect_decl_graph__find_node(shaking_context->decl_graph, decl_id)->root =
+                resect_cursor_is_root(shaking_context->filtering, cursor);
 
         resect_decl_graph_adopt(shaking_context->decl_graph, resect_shaking_context_root_id(shaking_context), decl_id);
     }
@@ -316,7 +344,7 @@ void resect_investigate_decl(resect_visit_context visit_context, resect_shaking_
         goto done;
     }
 
-    resect_investigate_owner(visit_context, shaking_context, cursor);
+    resect_investigate_owner(visit_context, shaking_context, cursor, decl_id);
     resect_investigate_template_specializations(visit_context, shaking_context, cursor);
 
     switch (decl_kind) {
@@ -445,7 +473,7 @@ void resect_investigate_template_arguments(resect_visit_context visit_context, r
 }
 
 static void resect_investigate_owner(resect_visit_context visit_context, resect_shaking_context context,
-                                     CXCursor cursor) {
+                                     CXCursor cursor, resect_string decl_id) {
     CXCursor owning_cursor = resect_find_declaration_owning_cursor(cursor);
     if (clang_Cursor_isNull(owning_cursor)) {
         return;
@@ -453,6 +481,15 @@ static void resect_investigate_owner(resect_visit_context visit_context, resect_
 
     // link to current declaration
     resect_visit_cursor(visit_context, owning_cursor, context);
+
+    // members are linked to the graph root, owners need to know them to pull them in from roots
+    resect_string owner_id = resect_extract_decl_id(owning_cursor);
+    resect_decl_graph_node owner = resect_decl_graph__find_node(context->decl_graph, owner_id);
+    resect_decl_graph_node member = resect_decl_graph__find_node(context->decl_graph, decl_id);
+    if (owner != NULL && member != NULL && owner != member) {
+        resect_table_put_if_absent(owner->members, resect_string_to_c(member->id), member);
+    }
+    resect_string_free(owner_id);
 }
 
 
@@ -598,7 +635,7 @@ typedef struct P_resect_inclusion_registry {
 } *resect_inclusion_registry;
 
 resect_inclusion_registry resect_inclusion_registry_create(resect_shaking_context shaking_context) {
-    resect_inclusion_registry registry = malloc(sizeof(struct P_resect_inclusion_registry));
+    resect_inclusion_registry registry = resect_allocate(sizeof(struct P_resect_inclusion_registry));
     registry->table = resect_table_create();
 
     resect_shaking_context__init_registry_table(shaking_context, registry->table);
@@ -628,7 +665,7 @@ bool resect_inclusion_registry_decl_included(resect_inclusion_registry registry,
 
 void resect_inclusion_registry_free(resect_inclusion_registry registry) {
     resect_table_free(registry->table, NULL, NULL);
-    free(registry);
+    resect_deallocate(registry);
 }
 
 static void *encode_inclusion_status(resect_inclusion_status new_status) {
@@ -664,11 +701,12 @@ static resect_promotion_result promote_registry_entry(resect_table registry, res
 
 
 static bool resect_shaking_context__follow_edge(resect_decl_graph graph, resect_decl_graph_edge edge,
-                                                resect_table registry, bool reinforced);
+                                                resect_table registry, bool reinforced, resect_set scope);
 
 typedef struct P_resect_follow_next_edge_data {
     resect_decl_graph graph;
     resect_table registry;
+    resect_set scope;
     resect_bool enforced;
     resect_decl_graph_edge edge;
 
@@ -679,7 +717,8 @@ static resect_bool follow_next_edge(void *ctx, const char *key, void *value) {
     resect_follow_next_edge_data visit_data = ctx;
 
     resect_decl_graph_edge next_edge = value;
-    if (resect_shaking_context__follow_edge(visit_data->graph, next_edge, visit_data->registry, visit_data->enforced)) {
+    if (resect_shaking_context__follow_edge(visit_data->graph, next_edge, visit_data->registry,
+                                            visit_data->enforced, visit_data->scope)) {
         // exclusion found, recursing out
         visit_data->result = true;
         return false;
@@ -688,11 +727,16 @@ static resect_bool follow_next_edge(void *ctx, const char *key, void *value) {
 }
 
 /**
+ * @param scope nodes reachable from roots, NULL if every node can be followed
  * @return true, if edge is excluded
  */
 static bool resect_shaking_context__follow_edge(resect_decl_graph graph, resect_decl_graph_edge edge,
-                                                resect_table registry, bool reinforced) {
+                                                resect_table registry, bool reinforced, resect_set scope) {
     resect_decl_graph_node target = resect_decl_graph__find_node(graph, edge->id);
+    if (scope != NULL && !resect_set_contains(scope, target)) {
+        return false;
+    }
+
     resect_inclusion_status new_status = RESECT_INCLUSION_STATUS_UNKNOWN;
 
     bool recurse = true;
@@ -734,7 +778,7 @@ static bool resect_shaking_context__follow_edge(resect_decl_graph graph, resect_
     }
 
     struct P_resect_follow_next_edge_data visit_data = {
-        .graph = graph, .registry = registry, .enforced = enforced, .edge = edge, .result = false
+        .graph = graph, .registry = registry, .scope = scope, .enforced = enforced, .edge = edge, .result = false
     };
     resect_visit_table(target->edges, follow_next_edge, &visit_data);
     if (visit_data.result) {
@@ -761,6 +805,7 @@ typedef struct P_resect_visit_edge_data {
     resect_shaking_context context;
     resect_decl_graph graph;
     resect_table registry;
+    resect_set scope;
 } *resect_visit_edge_data;
 
 static resect_bool visit_root_edge(void *ctx, const char *key, void *value) {
@@ -770,12 +815,20 @@ static resect_bool visit_root_edge(void *ctx, const char *key, void *value) {
     resect_table registry = visit_data->registry;
 
     resect_decl_graph_node node = resect_decl_graph__find_node(graph, edge->id);
-    if ((node->filter_status == RESECT_FILTER_STATUS_INCLUDED ||
-         node->filter_status == RESECT_FILTER_STATUS_ENFORCED) &&
+    bool selected;
+    if (visit_data->scope != NULL) {
+        // everything reachable from roots is selected unless filtered out explicitly
+        selected = resect_set_contains(visit_data->scope, node) && node->filter_status != RESECT_FILTER_STATUS_EXCLUDED;
+    } else {
+        selected = node->filter_status == RESECT_FILTER_STATUS_INCLUDED ||
+                   node->filter_status == RESECT_FILTER_STATUS_ENFORCED;
+    }
+    if (selected &&
         (node->access_level == RESECT_ACCESS_LEVEL_PUBLIC ||
          node->access_level == RESECT_ACCESS_LEVEL_UNKNOWN)) {
         bool excluded = resect_shaking_context__follow_edge(graph, edge, registry,
-                                                            node->filter_status == RESECT_FILTER_STATUS_ENFORCED);
+                                                            node->filter_status == RESECT_FILTER_STATUS_ENFORCED,
+                                                            visit_data->scope);
         if (excluded) {
             update_registry_entry(registry, node->id, RESECT_INCLUSION_STATUS_EXCLUDED);
         }
@@ -853,15 +906,163 @@ static resect_bool reset_excluded(void *ctx, void *item) {
     return true;
 }
 
+static resect_bool count_graph_node(void *ctx, const char *key, void *value) {
+    resect_stats stats = ctx;
+    resect_decl_graph_node node = value;
+    resect_stats_count(stats, RESECT_COUNTER_DECL_GRAPH_NODES, 1);
+    resect_stats_count(stats, RESECT_COUNTER_DECL_GRAPH_EDGES, resect_table_size(node->edges));
+    return true;
+}
+
+typedef struct P_resect_link_dependencies_data {
+    resect_translation_context context;
+    resect_decl decl;
+} *resect_link_dependencies_data;
+
+static resect_bool link_edge_dependency(void *ctx, const char *key, void *value) {
+    resect_link_dependencies_data data = ctx;
+    resect_decl_graph_edge edge = value;
+
+    resect_decl dependency = resect_context_find_registered_decl(data->context, resect_string_to_c(edge->id));
+    if (dependency != NULL && dependency != data->decl) {
+        resect_decl_add_dependency(data->decl, dependency);
+    }
+    return true;
+}
+
+static resect_bool link_node_dependencies(void *ctx, const char *key, void *value) {
+    resect_translation_context context = ctx;
+    resect_decl_graph_node node = value;
+
+    // root node links every decl and has no decl of its own
+    resect_decl decl = resect_context_find_registered_decl(context, key);
+    if (decl != NULL) {
+        struct P_resect_link_dependencies_data data = {.context = context, .decl = decl};
+        resect_visit_table(node->edges, link_edge_dependency, &data);
+    }
+    return true;
+}
+
+void resect_shaking_context_link_dependencies(resect_shaking_context shaking_context,
+                                              resect_translation_context context) {
+    resect_visit_table(shaking_context->decl_graph->node_table, link_node_dependencies, context);
+}
+
+/*
+ * ROOTS
+ */
+static bool is_hop_kind(resect_decl_kind kind) {
+    switch (kind) {
+        case RESECT_DECL_KIND_STRUCT:
+        case RESECT_DECL_KIND_CLASS:
+        case RESECT_DECL_KIND_UNION:
+        case RESECT_DECL_KIND_ENUM:
+        case RESECT_DECL_KIND_FUNCTION:
+        case RESECT_DECL_KIND_VARIABLE:
+        case RESECT_DECL_KIND_TYPEDEF:
+            return true;
+        default:
+            // members and parameters come along with their owners
+            return false;
+    }
+}
+
+typedef struct P_resect_scope_visit_data {
+    resect_decl_graph graph;
+    resect_set scope;
+    resect_collection current_level;
+    resect_collection next_level;
+    bool last_level;
+} *resect_scope_visit_data;
+
+static void enqueue_scope_node(resect_scope_visit_data data, resect_decl_graph_node node) {
+    if (resect_set_contains(data->scope, node)) {
+        return;
+    }
+    if (!is_hop_kind(node->kind)) {
+        resect_collection_add(data->current_level, node);
+    } else if (!data->last_level) {
+        resect_collection_add(data->next_level, node);
+    }
+}
+
+static resect_bool enqueue_edge_target(void *ctx, const char *key, void *value) {
+    resect_scope_visit_data data = ctx;
+    resect_decl_graph_edge edge = value;
+    enqueue_scope_node(data, resect_decl_graph__find_node(data->graph, edge->id));
+    return true;
+}
+
+static resect_bool enqueue_member(void *ctx, const char *key, void *value) {
+    enqueue_scope_node(ctx, value);
+    return true;
+}
+
+static resect_bool enqueue_root(void *ctx, const char *key, void *value) {
+    resect_scope_visit_data data = ctx;
+    resect_decl_graph_node node = value;
+    if (node->root || node->filter_status == RESECT_FILTER_STATUS_ENFORCED) {
+        resect_collection_add(data->current_level, node);
+    }
+    return true;
+}
+
+static resect_set resect_shaking_context__collect_scope(resect_shaking_context shaking_context) {
+    struct P_resect_scope_visit_data data = {
+        .graph = shaking_context->decl_graph,
+        .scope = resect_set_create(),
+        .current_level = resect_collection_create(),
+        .next_level = resect_collection_create(),
+        .last_level = false
+    };
+    resect_visit_table(data.graph->node_table, enqueue_root, &data);
+
+    // breadth first, so every node is reached with the least number of hops
+    for (unsigned int hops = 0; resect_collection_size(data.current_level) > 0; ++hops) {
+        data.last_level = shaking_context->root_hop_limit > 0 && hops >= shaking_context->root_hop_limit;
+
+        resect_decl_graph_node node;
+        while ((node = resect_collection_pop_last(data.current_level)) != NULL) {
+            if (!resect_set_add(data.scope, node)) {
+                continue;
+            }
+            resect_visit_table(node->edges, enqueue_edge_target, &data);
+            resect_visit_table(node->members, enqueue_member, &data);
+        }
+
+        resect_collection level = data.current_level;
+        data.current_level = data.next_level;
+        data.next_level = level;
+    }
+
+    resect_collection_free(data.current_level);
+    resect_collection_free(data.next_level);
+
+    if (shaking_context->diagnostics_level >= RESECT_DIAGNOSTICS_ALL) {
+        fprintf(stderr, "(libresect) %u declarations reachable from roots\n", resect_set_size(data.scope));
+    }
+
+    return data.scope;
+}
+
 static void resect_shaking_context__init_registry_table(resect_shaking_context shaking_context, resect_table registry) {
     resect_decl_graph graph = shaking_context->decl_graph;
+    if (shaking_context->stats != NULL) {
+        resect_visit_table(graph->node_table, count_graph_node, shaking_context->stats);
+    }
     resect_decl_graph_node root = resect_decl_graph__find_node(graph, shaking_context->root_decl_id);
     resect_set enforced_nodes = resect_set_create();
 
+    // in roots mode only declarations reachable from roots are considered
+    resect_set scope = resect_filtering_has_roots(shaking_context->filtering)
+                           ? resect_shaking_context__collect_scope(shaking_context)
+                           : NULL;
+
     struct P_resect_visit_edge_data visit_data = {
         .context = shaking_context,
         .graph = graph,
         .registry = registry,
+        .scope = scope,
     };
 
     resect_visit_table(root->edges, visit_root_edge, &visit_data);
@@ -886,4 +1087,7 @@ static void resect_shaking_context__init_registry_table(resect_shaking_context s
     }
 
     resect_set_free(enforced_nodes);
+    if (scope != NULL) {
+        resect_set_free(scope);
+    }
 }
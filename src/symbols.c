@@ -0,0 +1,195 @@
+#include "../resect.h"
+#include "resect_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * ELF
+ */
+#define RESECT_ELF_IDENT_SIZE 16
+#define RESECT_ELF_CLASS_32 1
+#define RESECT_ELF_CLASS_64 2
+#define RESECT_ELF_DATA_LSB 1
+#define RESECT_ELF_DATA_MSB 2
+#define RESECT_ELF_SECTION_DYNSYM 11
+#define RESECT_ELF_SECTION_UNDEFINED 0
+#define RESECT_ELF_BINDING_LOCAL 0
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    bool is_64;
+    bool is_msb;
+} resect_elf_image;
+
+static bool resect_elf_in_bounds(resect_elf_image *image, uint64_t offset, uint64_t length) {
+    return offset <= image->size && length <= image->size - offset;
+}
+
+static uint64_t resect_elf_read(resect_elf_image *image, uint64_t offset, int width) {
+    const unsigned char *bytes = image->data + offset;
+    uint64_t result = 0;
+    for (int i = 0; i < width; ++i) {
+        int shift = image->is_msb ? (width - i - 1) * 8 : i * 8;
+        result |= ((uint64_t) bytes[i]) << shift;
+    }
+    return result;
+}
+
+static uint64_t resect_elf_read_word(resect_elf_image *image, uint64_t offset) {
+    return resect_elf_read(image, offset, image->is_64 ? 8 : 4);
+}
+
+static bool resect_elf_image_init(resect_elf_image *image, const void *data, size_t size) {
+    static const unsigned char magic[] = {0x7f, 'E', 'L', 'F'};
+
+    image->data = data;
+    image->size = size;
+
+    if (size < RESECT_ELF_IDENT_SIZE || memcmp(data, magic, sizeof(magic)) != 0) {
+        return false;
+    }
+
+    switch (image->data[4]) {
+        case RESECT_ELF_CLASS_32:
+            image->is_64 = false;
+            break;
+        case RESECT_ELF_CLASS_64:
+            image->is_64 = true;
+            break;
+        default:
+            return false;
+    }
+
+    switch (image->data[5]) {
+        case RESECT_ELF_DATA_LSB:
+            image->is_msb = false;
+            break;
+        case RESECT_ELF_DATA_MSB:
+            image->is_msb = true;
+            break;
+        default:
+            return false;
+    }
+
+    return resect_elf_in_bounds(image, 0, image->is_64 ? 64 : 52);
+}
+
+static void resect_elf_collect_symbols(resect_elf_image *image,
+                                       uint64_t symbols_offset, uint64_t symbols_size, uint64_t symbol_size,
+                                       uint64_t names_offset, uint64_t names_size,
+                                       resect_table result) {
+    if (symbol_size == 0
+        || !resect_elf_in_bounds(image, symbols_offset, symbols_size)
+        || !resect_elf_in_bounds(image, names_offset, names_size)) {
+        return;
+    }
+
+    const char *names = (const char *) image->data + names_offset;
+    for (uint64_t offset = symbols_offset;
+         offset + symbol_size <= symbols_offset + symbols_size;
+         offset += symbol_size) {
+        uint64_t name_offset = resect_elf_read(image, offset, 4);
+        unsigned char info = image->data[offset + (image->is_64 ? 4 : 12)];
+        uint64_t section_index = resect_elf_read(image, offset + (image->is_64 ? 6 : 14), 2);
+
+        if (name_offset == 0 || name_offset >= names_size
+            || section_index == RESECT_ELF_SECTION_UNDEFINED
+            || (info >> 4) == RESECT_ELF_BINDING_LOCAL) {
+            continue;
+        }
+
+        const char *name = names + name_offset;
+        if (memchr(name, '\0', names_size - name_offset) == NULL) {
+            continue;
+        }
+        resect_table_put_if_absent(result, name, result);
+    }
+}
+
+static bool resect_elf_read_dynamic_symbols(resect_elf_image *image, resect_table result) {
+    uint64_t section_table_offset = resect_elf_read_word(image, image->is_64 ? 40 : 32);
+    uint64_t section_header_size = resect_elf_read(image, image->is_64 ? 58 : 46, 2);
+    uint64_t section_count = resect_elf_read(image, image->is_64 ? 60 : 48, 2);
+
+    uint64_t minimal_header_size = image->is_64 ? 64 : 40;
+    if (section_header_size < minimal_header_size
+        || !resect_elf_in_bounds(image, section_table_offset, section_header_size * section_count)) {
+        return false;
+    }
+
+    bool found = false;
+    for (uint64_t i = 0; i < section_count; ++i) {
+        uint64_t header = section_table_offset + i * section_header_size;
+        if (resect_elf_read(image, header + 4, 4) != RESECT_ELF_SECTION_DYNSYM) {
+            continue;
+        }
+
+        uint64_t offset = resect_elf_read_word(image, header + (image->is_64 ? 24 : 16));
+        uint64_t size = resect_elf_read_word(image, header + (image->is_64 ? 32 : 20));
+        uint64_t link = resect_elf_read(image, header + (image->is_64 ? 40 : 24), 4);
+        uint64_t entry_size = resect_elf_read_word(image, header + (image->is_64 ? 56 : 36));
+
+        if (link >= section_count) {
+            continue;
+        }
+
+        uint64_t names_header = section_table_offset + link * section_header_size;
+        uint64_t names_offset = resect_elf_read_word(image, names_header + (image->is_64 ? 24 : 16));
+        uint64_t names_size = resect_elf_read_word(image, names_header + (image->is_64 ? 32 : 20));
+
+        resect_elf_collect_symbols(image, offset, size, entry_size, names_offset, names_size, result);
+        found = true;
+    }
+
+    return found;
+}
+
+/*
+ * SYMBOL TABLE
+ */
+struct P_resect_symbol_table {
+    resect_table symbols;
+};
+
+resect_symbol_table resect_symbol_table_load(const char *library_path) {
+    resect_file_mapping mapping = resect_file_mapping_open(library_path);
+    if (mapping == NULL) {
+        return NULL;
+    }
+
+    resect_symbol_table table = NULL;
+
+    resect_elf_image image;
+    if (!resect_elf_image_init(&image, resect_file_mapping_data(mapping), resect_file_mapping_size(mapping))) {
+        goto done;
+    }
+
+    resect_table symbols = resect_table_create();
+    if (!resect_elf_read_dynamic_symbols(&image, symbols)) {
+        resect_table_free(symbols, NULL, NULL);
+        goto done;
+    }
+
+    table = resect_allocate(sizeof(struct P_resect_symbol_table));
+    table->symbols = symbols;
+
+done:
+    resect_file_mapping_close(mapping);
+    return table;
+}
+
+bool resect_symbol_table_contains(resect_symbol_table table, const char *symbol) {
+    return resect_table_get(table->symbols, symbol) != NULL;
+}
+
+unsigned int resect_symbol_table_size(resect_symbol_table table) {
+    return resect_table_size(table->symbols);
+}
+
+void resect_symbol_table_free(resect_symbol_table table) {
+    resect_table_free(table->symbols, NULL, NULL);
+    resect_deallocate(table);
+}
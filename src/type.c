@@ -22,20 +22,28 @@ struct P_resect_type_field {
 struct P_resect_type {
     resect_type_kind kind;
     resect_string name;
-    unsigned int size;
-    unsigned int alignment;
+    long long size;
+    long long alignment;
     resect_type_category category;
     resect_collection fields;
+    // built on first lookup
+    resect_type_field *field_array;
+    resect_table field_index;
     resect_collection base_classes;
     resect_collection methods;
     resect_bool const_qualified;
     resect_bool pod;
     resect_bool undeclared;
+    resect_bool truncated;
+    // reached only through pointers or references, members are visited once reached directly
+    resect_bool opaque;
     resect_collection template_arguments;
 
     resect_decl decl;
 
     resect_bool initialized;
+    // id of the worker building the type, 0 once it's built
+    volatile unsigned int builder;
     resect_data_deallocator data_deallocator;
     void *data;
 };
@@ -97,7 +105,7 @@ resect_type_method resect_method_create(resect_visit_context visit_context, rese
         goto done;
     }
 
-    method = malloc(sizeof(struct P_resect_type_method));
+    method = resect_allocate(sizeof(struct P_resect_type_method));
     method->id = resect_string_copy(method_id);
     method->name = resect_string_from_clang(clang_getCursorSpelling(cursor));
     method->mangling = extract_mangling(cursor);
@@ -123,7 +131,7 @@ void resect_method_free(resect_type_method method, resect_set deallocated) {
     if (method->decl != NULL) {
         resect_decl_free(method->decl, deallocated);
     }
-    free(method);
+    resect_deallocate(method);
 }
 
 void resect_method_collection_free(resect_type type, resect_set deallocated) {
@@ -137,7 +145,7 @@ void resect_method_collection_free(resect_type type, resect_set deallocated) {
 }
 
 void resect_type_free(resect_type type, resect_set deallocated) {
-    if (!resect_set_add(deallocated, type)) {
+    if (type == NULL || !resect_set_add(deallocated, type)) {
         return;
     }
 
@@ -146,6 +154,7 @@ void resect_type_free(resect_type type, resect_set deallocated) {
     }
 
     resect_string_free(type->name);
+    resect_type_field_index_free(type);
     resect_field_collection_free(type->fields, deallocated);
     resect_type_collection_free(type->base_classes, deallocated);
     resect_method_collection_free(type, deallocated);
@@ -155,7 +164,7 @@ void resect_type_free(resect_type type, resect_set deallocated) {
         resect_decl_free(type->decl, deallocated);
     }
 
-    free(type);
+    resect_deallocate(type);
 }
 
 resect_type_field resect_field_create(resect_visit_context visit_context, resect_translation_context context,
@@ -167,11 +176,12 @@ resect_type_field resect_field_create(resect_visit_context visit_context, resect
         goto done;
     }
 
-    field = malloc(sizeof(struct P_resect_type_field));
+    field = resect_allocate(sizeof(struct P_resect_type_field));
     field->id = resect_string_copy(field_id);
     field->type = resect_type_create(visit_context, context, clang_getCursorType(cursor));
     field->name = resect_string_from_clang(clang_getCursorDisplayName(cursor));
-    field->offset = clang_Type_getOffsetOf(parent, resect_string_to_c(field->name));
+    // unlike lookup by name, this works for anonymous struct and union members too
+    field->offset = clang_Cursor_getOffsetOfField(cursor);
     field->is_mutable = convert_bool_from_uint(clang_CXXField_isMutable(cursor));
 
 done:
@@ -219,11 +229,18 @@ resect_decl resect_type_method_get_decl(resect_type_method method) {
     return method->decl;
 }
 
+resect_symbol_status resect_type_method_get_symbol_status(resect_type_method method) {
+    if (method->decl == NULL) {
+        return RESECT_SYMBOL_STATUS_UNKNOWN;
+    }
+    return resect_decl_get_symbol_status(method->decl);
+}
+
 void resect_field_free(resect_type_field field, resect_set deallocated) {
     resect_type_free(field->type, deallocated);
     resect_string_free(field->name);
     resect_string_free(field->id);
-    free(field);
+    resect_deallocate(field);
 }
 
 void resect_field_collection_free(resect_collection fields, resect_set deallocated) {
@@ -276,6 +293,11 @@ typedef struct P_resect_type_visit_data {
 static enum CXVisitorResult visit_type_field(CXCursor cursor, CXClientData data) {
     resect_type_visit_data visit_data = data;
 
+    // layout stays intact, offsets of public fields and record size come from clang
+    if (resect_context_public_only(visit_data->context) && !resect_is_public_member(cursor)) {
+        return CXVisit_Continue;
+    }
+
     resect_type_field field =
             resect_field_create(visit_data->visit_context, visit_data->context, visit_data->parent, cursor);
     if (field != NULL) {
@@ -303,6 +325,10 @@ static enum CXVisitorResult visit_type_base_class(CXCursor cursor, CXClientData
 static enum CXVisitorResult visit_type_method(CXCursor cursor, CXClientData data) {
     resect_type_visit_data visit_data = data;
 
+    if (resect_context_public_only(visit_data->context) && !resect_is_public_member(cursor)) {
+        return CXVisit_Continue;
+    }
+
     resect_type_method type_method = resect_method_create(visit_data->visit_context, visit_data->context, cursor);
     if (type_method != NULL) {
         resect_collection_add(visit_data->type->methods, type_method);
@@ -326,12 +352,12 @@ void resect_array_data_free(void *data, resect_set deallocated) {
 
     resect_array_data array_data = data;
     resect_type_free(array_data->type, deallocated);
-    free(data);
+    resect_deallocate(data);
 }
 
 void resect_array_init(resect_visit_context visit_context, resect_translation_context context, resect_type type,
                        CXType clangType) {
-    resect_array_data data = malloc(sizeof(struct P_resect_array_data));
+    resect_array_data data = resect_allocate(sizeof(struct P_resect_array_data));
     data->type = resect_type_create(visit_context, context, clang_getArrayElementType(clangType));
     data->size = clang_getArraySize(clangType);
 
@@ -369,13 +395,15 @@ void resect_pointer_data_free(void *data, resect_set deallocated) {
     if (pointer->member_owner != NULL) {
         resect_type_free(pointer->member_owner, deallocated);
     }
-    free(data);
+    resect_deallocate(data);
 }
 
 void resect_pointer_init(resect_visit_context visit_context, resect_translation_context context, resect_type type,
                          CXType clang_type) {
-    resect_pointer_data data = malloc(sizeof(struct P_resect_pointer_data));
+    resect_pointer_data data = resect_allocate(sizeof(struct P_resect_pointer_data));
+    resect_context_enter_pointee(context);
     data->type = resect_type_create(visit_context, context, clang_getPointeeType(clang_type));
+    resect_context_leave_pointee(context);
 
     // libclang cannot handle templated member-pointers
     // sizeof check here helps to filter out dependent types
@@ -415,14 +443,16 @@ void resect_reference_data_free(void *data, resect_set deallocated) {
     }
     resect_reference_data pointer = data;
     resect_type_free(pointer->type, deallocated);
-    free(data);
+    resect_deallocate(data);
 }
 
 void resect_reference_init(resect_visit_context visit_context, resect_translation_context context, resect_type type,
                            CXType clangType) {
-    resect_reference_data data = malloc(sizeof(struct P_resect_reference_data));
+    resect_reference_data data = resect_allocate(sizeof(struct P_resect_reference_data));
 
+    resect_context_enter_pointee(context);
     data->type = resect_type_create(visit_context, context, clang_getPointeeType(clangType));
+    resect_context_leave_pointee(context);
     data->is_lvalue = clangType.kind == CXType_LValueReference;
 
     type->data_deallocator = resect_reference_data_free;
@@ -458,12 +488,15 @@ void resect_function_proto_free(void *data, resect_set deallocated) {
     resect_type_free(function_proto->result_type, deallocated);
     resect_type_collection_free(function_proto->parameters, deallocated);
 
-    free(data);
+    resect_deallocate(data);
 }
 
 void resect_function_proto_init(resect_visit_context visit_context, resect_translation_context context,
                                 resect_type type, CXType clangType) {
-    resect_function_proto_data data = malloc(sizeof(struct P_resect_function_proto_data));
+    // parameters and results are passed by value even when the function itself is only pointed to
+    unsigned int pointee_depth = resect_context_suspend_pointee(context);
+
+    resect_function_proto_data data = resect_allocate(sizeof(struct P_resect_function_proto_data));
     data->result_type = resect_type_create(visit_context, context, clang_getResultType(clangType));
     data->variadic = convert_bool_from_uint(clang_isFunctionTypeVariadic(clangType));
     data->parameters = resect_collection_create();
@@ -474,6 +507,8 @@ void resect_function_proto_init(resect_visit_context visit_context, resect_trans
         resect_collection_add(data->parameters, resect_type_create(visit_context, context, arg_type));
     }
 
+    resect_context_resume_pointee(context, pointee_depth);
+
     type->data_deallocator = resect_function_proto_free;
     type->data = data;
 }
@@ -601,6 +636,99 @@ resect_type_category get_type_category(resect_type_kind kind) {
 /*
  * TYPE CONSTRUCTOR
  */
+static void visit_type_members(resect_visit_context visit_context, resect_translation_context context,
+                               resect_type type, CXType clang_type) {
+    struct P_resect_type_visit_data visit_data = {
+        .type = type, .visit_context = visit_context, .context = context, .parent = clang_type
+    };
+
+    clang_Type_visitFields(clang_type, visit_type_field, &visit_data);
+    clang_visitCXXBaseClasses(clang_type, visit_type_base_class, &visit_data);
+    clang_visitCXXMethods(clang_type, visit_type_method, &visit_data);
+}
+
+/**
+ * Members, template arguments and specializations are what makes type graphs explode, so they are skipped
+ * for types reached past the limits. Template depth limit only affects template specializations, plain records
+ * and enums get their members wherever they are reached.
+ * @return NULL if type can be completed
+ */
+static const char *get_truncation_reason(resect_translation_context context, resect_type type) {
+    resect_decl root_template = resect_decl_get_root_template(type->decl);
+    if (resect_context_memory_exhausted(context)) {
+        return "memory limit reached";
+    }
+    if (root_template != NULL && resect_context_template_depth_exceeded(context)) {
+        return "template argument depth limit reached";
+    }
+    if (root_template != NULL) {
+        // specializations are registered by every worker reaching them
+        resect_context_lock(context);
+        unsigned int specialization_count = resect_decl_specialization_count(root_template);
+        resect_context_unlock(context);
+        if (resect_context_specialization_limit_reached(context, specialization_count)) {
+            return "specialization limit reached";
+        }
+    }
+    return NULL;
+}
+
+static void complete_type(resect_visit_context visit_context, resect_translation_context context,
+                          resect_type type, CXType clang_type) {
+    resect_context_enter_template_arguments(context);
+    resect_init_template_args_from_type(visit_context, context, type->template_arguments, clang_type);
+    resect_context_leave_template_arguments(context);
+
+    resect_decl root_template = resect_decl_get_root_template(type->decl);
+    if (root_template != NULL) {
+        resect_context_lock(context);
+        resect_decl_register_specialization(root_template, type);
+        resect_context_unlock(context);
+    }
+
+    if (resect_context_opaque_pointee(context) && clang_getCanonicalType(clang_type).kind == CXType_Record) {
+        type->opaque = resect_true;
+    } else {
+        visit_type_members(visit_context, context, type, clang_type);
+    }
+}
+
+static bool needs_completion(resect_translation_context context, resect_type type) {
+    return type->truncated && type->initialized && get_truncation_reason(context, type) == NULL
+           || type->opaque && !resect_context_opaque_pointee(context);
+}
+
+/**
+ * Type registered before is reached again, possibly by another worker.
+ */
+static void reach_type(resect_visit_context visit_context, resect_translation_context context,
+                       resect_type type, CXType clang_type) {
+    if (!resect_context_await_build(context, &type->builder) || !needs_completion(context, type)) {
+        return;
+    }
+
+    resect_build_claim claim = resect_context_claim_build(context, &type->builder);
+    if (claim == RESECT_BUILD_BUSY) {
+        return;
+    }
+
+    // checked again, another worker might have completed the type in the meantime
+    if (type->truncated && type->initialized && get_truncation_reason(context, type) == NULL) {
+        // reached within the limits this time, so the type doesn't need to stay truncated
+        type->truncated = resect_false;
+        complete_type(visit_context, context, type, clang_type);
+    } else if (type->opaque && !resect_context_opaque_pointee(context)) {
+        // reached directly this time, complete the declaration and the members
+        type->opaque = resect_false;
+        resect_decl_create(visit_context, context, clang_getTypeDeclaration(clang_type));
+        visit_type_members(visit_context, context, type, clang_type);
+    }
+
+    if (claim == RESECT_BUILD_CLAIMED) {
+        resect_context_end_build(context, &type->builder);
+    }
+}
+
 resect_type resect_type_create(resect_visit_context visit_context, resect_translation_context context,
                                CXType clang_type) {
     switch (clang_type.kind) {
@@ -621,14 +749,35 @@ resect_type resect_type_create(resect_visit_context visit_context, resect_transl
 
     resect_type type = resect_find_type(context, clang_type);
     if (type != NULL) {
+        reach_type(visit_context, context, type, clang_type);
         return type;
     }
 
-    type = malloc(sizeof(struct P_resect_type));
+    CXCursor declaration_cursor = clang_getTypeDeclaration(clang_type);
+    resect_string type_name = resect_string_fqn_from_type(context, clang_type);
+
+    // clang types differ between translation units parsed by workers, so declared types are shared by name
+    resect_string type_key = NULL;
+    if (declaration_cursor.kind != CXCursor_NoDeclFound) {
+        resect_string decl_id = resect_extract_decl_id(declaration_cursor);
+        type_key = resect_string_format("%s %s", resect_string_to_c(decl_id), resect_string_to_c(type_name));
+        resect_string_free(decl_id);
+
+        type = resect_find_declared_type(context, type_key);
+        if (type != NULL) {
+            resect_string_free(type_key);
+            resect_string_free(type_name);
+            resect_register_type(context, clang_type, type);
+            reach_type(visit_context, context, type, clang_type);
+            return type;
+        }
+    }
+
+    type = resect_allocate(sizeof(struct P_resect_type));
     type->initialized = false;
     type->kind = convert_type_kind(clang_type.kind);
     type->category = get_type_category(type->kind);
-    type->name = resect_string_fqn_from_type(context, clang_type);
+    type->name = type_name;
 
     long long int size = clang_Type_getSizeOf(clang_type);
     if (size <= 0) {
@@ -640,19 +789,41 @@ resect_type resect_type_create(resect_visit_context visit_context, resect_transl
         type->alignment = 8 * filter_valid_value(clang_Type_getAlignOf(clang_type));
     }
     type->fields = resect_collection_create();
+    type->field_array = NULL;
+    type->field_index = NULL;
     type->base_classes = resect_collection_create();
     type->methods = resect_collection_create();
     type->const_qualified = convert_bool_from_uint(clang_isConstQualifiedType(clang_type));
     type->pod = convert_bool_from_uint(clang_isPODType(clang_type));
     type->template_arguments = resect_collection_create();
     type->decl = NULL;
+    type->truncated = resect_false;
+    type->opaque = resect_false;
 
     type->data_deallocator = NULL;
     type->data = NULL;
+    type->builder = 0;
+
+    bool shared = type_key != NULL;
+    if (shared) {
+        resect_context_begin_build(context, &type->builder);
+        resect_type registered_type = resect_register_declared_type(context, type_key, type);
+        resect_string_free(type_key);
+        if (registered_type != type) {
+            // another worker got here first, nothing references this type yet
+            resect_set deallocated = resect_set_create();
+            resect_type_free(type, deallocated);
+            resect_set_free(deallocated);
+
+            resect_register_type(context, clang_type, registered_type);
+            reach_type(visit_context, context, registered_type, clang_type);
+            return registered_type;
+        }
+    }
 
+    resect_stats_count(resect_context_stats(context), RESECT_COUNTER_TYPES_CREATED, 1);
     resect_register_type(context, clang_type, type);
 
-    CXCursor declaration_cursor = clang_getTypeDeclaration(clang_type);
     if (declaration_cursor.kind == CXCursor_NoDeclFound) {
         type->undeclared = resect_true;
         type->decl = NULL;
@@ -700,7 +871,21 @@ resect_type resect_type_create(resect_visit_context visit_context, resect_transl
 
     type->initialized = true;
 
-    if (type->decl != NULL) {
+    if (type->decl == NULL) {
+        if (shared) {
+            resect_context_end_build(context, &type->builder);
+        }
+        return type;
+    }
+
+    const char *truncation_reason = get_truncation_reason(context, type);
+    if (truncation_reason != NULL) {
+        type->truncated = resect_true;
+        if (resect_context_diagnostics_level(context) >= RESECT_DIAGNOSTICS_WARNING) {
+            fprintf(stderr, "(libresect) Type %s is truncated: %s\n",
+                    resect_string_to_c(type->name), truncation_reason);
+        }
+    } else {
         if (resect_context_diagnostics_level(context) >= RESECT_DIAGNOSTICS_WARNING
             && clang_isInvalidDeclaration(declaration_cursor)) {
             resect_string decl_id = resect_extract_decl_id(declaration_cursor);
@@ -708,19 +893,10 @@ resect_type resect_type_create(resect_visit_context visit_context, resect_transl
                 resect_string_to_c(decl_id), resect_string_to_c(type->name));
             resect_string_free(decl_id);
         }
-        resect_init_template_args_from_type(visit_context, context, type->template_arguments, clang_type);
-        resect_decl root_template = resect_decl_get_root_template(type->decl);
-        if (root_template != NULL) {
-            resect_decl_register_specialization(root_template, type);
-        }
-
-        struct P_resect_type_visit_data visit_data = {
-            .type = type, .visit_context = visit_context, .context = context, .parent = clang_type
-        };
-
-        clang_Type_visitFields(clang_type, visit_type_field, &visit_data);
-        clang_visitCXXBaseClasses(clang_type, visit_type_base_class, &visit_data);
-        clang_visitCXXMethods(clang_type, visit_type_method, &visit_data);
+        complete_type(visit_context, context, type, clang_type);
+    }
+    if (shared) {
+        resect_context_end_build(context, &type->builder);
     }
 
     return type;
@@ -728,6 +904,10 @@ resect_type resect_type_create(resect_visit_context visit_context, resect_transl
 
 resect_bool resect_type_is_undeclared(resect_type type) { return type->undeclared; }
 
+resect_bool resect_type_is_truncated(resect_type type) { return type->truncated; }
+
+resect_bool resect_type_is_opaque(resect_type type) { return type->opaque; }
+
 resect_type_kind resect_type_get_kind(resect_type type) { return type->kind; }
 
 const char *resect_type_get_name(resect_type type) { return resect_string_to_c(type->name); }
@@ -736,18 +916,106 @@ long long resect_type_sizeof(resect_type type) { return type->size; }
 
 long long resect_type_alignof(resect_type type) { return type->alignment; }
 
-long long resect_type_offsetof(resect_type type, const char *field_name) {
-    resect_iterator iterator = resect_collection_iterator(type->fields);
-    long long result = -1;
-    while (resect_iterator_next(iterator)) {
-        resect_type_field field = resect_iterator_value(iterator);
-        if (resect_string_equal_c(field->name, field_name)) {
-            result = field->offset;
-            break;
+/*
+ * FIELD INDEX
+ */
+typedef struct P_resect_indexed_field {
+    resect_type_field field;
+    // offset of the field within the indexed type, differs from field offset for anonymous members
+    long long offset;
+} *resect_indexed_field;
+
+static void index_fields(resect_table index, resect_collection fields, long long base_offset) {
+    resect_iterator iter = resect_collection_iterator(fields);
+    while (resect_iterator_next(iter)) {
+        resect_type_field field = resect_iterator_value(iter);
+        if (resect_string_equal_c(field->name, "")) {
+            // members of anonymous structs and unions are accessed as if they were declared in the parent
+            if (field->type != NULL && field->offset >= 0) {
+                index_fields(index, field->type->fields, base_offset + field->offset);
+            }
+            continue;
+        }
+
+        resect_indexed_field indexed = resect_allocate(sizeof(struct P_resect_indexed_field));
+        indexed->field = field;
+        indexed->offset = base_offset + field->offset;
+        if (!resect_table_put_if_absent(index, resect_string_to_c(field->name), indexed)) {
+            resect_deallocate(indexed);
         }
     }
-    resect_iterator_free(iterator);
-    return result;
+    resect_iterator_free(iter);
+}
+
+static void ensure_field_index(resect_type type) {
+    if (type->field_index != NULL) {
+        return;
+    }
+
+    unsigned int field_count = resect_collection_size(type->fields);
+    type->field_array = resect_allocate((field_count > 0 ? field_count : 1) * sizeof(resect_type_field));
+    unsigned int i = 0;
+    resect_iterator iter = resect_collection_iterator(type->fields);
+    while (resect_iterator_next(iter)) {
+        type->field_array[i++] = resect_iterator_value(iter);
+    }
+    resect_iterator_free(iter);
+
+    type->field_index = resect_table_create();
+    index_fields(type->field_index, type->fields, 0);
+}
+
+static void free_indexed_field(void *context, void *value) { resect_deallocate(value); }
+
+void resect_type_field_index_free(resect_type type) {
+    if (type->field_index != NULL) {
+        resect_table_free(type->field_index, free_indexed_field, NULL);
+        resect_deallocate(type->field_array);
+        type->field_index = NULL;
+        type->field_array = NULL;
+    }
+}
+
+resect_type_field resect_type_field_at(resect_type type, unsigned int index) {
+    if (index >= resect_collection_size(type->fields)) {
+        return NULL;
+    }
+    ensure_field_index(type);
+    return type->field_array[index];
+}
+
+/**
+ * @param field_path field name or names of nested fields separated by dots, e.g. "a.b.c"
+ * @return offset in bits or -1 if there's no such field
+ */
+long long resect_type_offsetof(resect_type type, const char *field_path) {
+    long long result = 0;
+    const char *segment = field_path;
+    while (type != NULL) {
+        const char *separator = strchr(segment, '.');
+        size_t length = separator != NULL ? (size_t) (separator - segment) : strlen(segment);
+
+        char *field_name = resect_allocate(length + 1);
+        memcpy(field_name, segment, length);
+        field_name[length] = '\0';
+
+        ensure_field_index(type);
+        resect_indexed_field indexed = resect_table_get(type->field_index, field_name);
+        resect_deallocate(field_name);
+
+        if (indexed == NULL || indexed->offset < 0) {
+            return -1;
+        }
+
+        result += indexed->offset;
+        if (separator == NULL) {
+            return result;
+        }
+
+        type = indexed->field->type;
+        segment = separator + 1;
+    }
+    return -1;
 }
 
 resect_collection resect_type_fields(resect_type type) { return type->fields; }
@@ -770,3 +1038,285 @@ resect_string resect_type_pretty_print(resect_translation_context context, CXTyp
     return resect_string_from_clang(clang_getTypePrettyPrinted(type,
                                                                resect_context_get_printing_policy(context)));
 }
+
+/*
+ * SERIALIZATION
+ */
+resect_type resect_type_allocate() {
+    resect_type type = resect_allocate(sizeof(struct P_resect_type));
+    memset(type, 0, sizeof(struct P_resect_type));
+    return type;
+}
+
+// field layout: id, type, name, offset (low and high bits), mutable
+#define TYPE_FIELD_RECORD_SIZE (6)
+
+// method layout: id, name, mangling, source, type, decl, static, const, constructor kind
+#define TYPE_METHOD_RECORD_SIZE (9)
+
+static uint32_t resect_type_fields_serialize(resect_type type, resect_writer writer) {
+    unsigned int count = resect_collection_size(type->fields);
+    uint32_t *values = resect_allocate(TYPE_FIELD_RECORD_SIZE * count * sizeof(uint32_t) + 1);
+
+    uint32_t *record = values;
+    resect_iterator iter = resect_collection_iterator(type->fields);
+    while (resect_iterator_next(iter)) {
+        resect_type_field field = resect_iterator_value(iter);
+        record[0] = resect_writer_string(writer, field->id);
+        record[1] = resect_writer_type(writer, field->type);
+        record[2] = resect_writer_string(writer, field->name);
+        record[3] = RESECT_LOW_BITS(field->offset);
+        record[4] = RESECT_HIGH_BITS(field->offset);
+        record[5] = field->is_mutable;
+        record += TYPE_FIELD_RECORD_SIZE;
+    }
+    resect_iterator_free(iter);
+
+    uint32_t first = resect_writer_block(writer, values, TYPE_FIELD_RECORD_SIZE * count);
+    resect_deallocate(values);
+    return first;
+}
+
+static void resect_type_fields_deserialize(resect_type type, resect_reader reader, uint32_t first, uint32_t count) {
+    if (!resect_reader_check_range(reader, first, (uint64_t) TYPE_FIELD_RECORD_SIZE * count)) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t offset = first + i * TYPE_FIELD_RECORD_SIZE;
+        resect_type_field field = resect_allocate(sizeof(struct P_resect_type_field));
+        field->id = resect_reader_string(reader, resect_reader_value(reader, offset));
+        field->type = resect_reader_type(reader, resect_reader_value(reader, offset + 1));
+        field->name = resect_reader_string(reader, resect_reader_value(reader, offset + 2));
+        field->offset = (long long) RESECT_JOIN_BITS(resect_reader_value(reader, offset + 3),
+                                                     resect_reader_value(reader, offset + 4));
+        field->is_mutable = resect_reader_value(reader, offset + 5);
+        resect_collection_add(type->fields, field);
+    }
+}
+
+static uint32_t resect_type_methods_serialize(resect_type type, resect_writer writer) {
+    unsigned int count = resect_collection_size(type->methods);
+    uint32_t *values = resect_allocate(TYPE_METHOD_RECORD_SIZE * count * sizeof(uint32_t) + 1);
+
+    uint32_t *record = values;
+    resect_iterator iter = resect_collection_iterator(type->methods);
+    while (resect_iterator_next(iter)) {
+        resect_type_method method = resect_iterator_value(iter);
+        record[0] = resect_writer_string(writer, method->id);
+        record[1] = resect_writer_string(writer, method->name);
+        record[2] = resect_writer_string(writer, method->mangling);
+        record[3] = resect_writer_string(writer, method->source);
+        record[4] = resect_writer_type(writer, method->type);
+        record[5] = resect_writer_decl(writer, method->decl);
+        record[6] = method->is_static;
+        record[7] = method->is_const;
+        record[8] = method->constructor_kind;
+        record += TYPE_METHOD_RECORD_SIZE;
+    }
+    resect_iterator_free(iter);
+
+    uint32_t first = resect_writer_block(writer, values, TYPE_METHOD_RECORD_SIZE * count);
+    resect_deallocate(values);
+    return first;
+}
+
+static void resect_type_methods_deserialize(resect_type type, resect_reader reader, uint32_t first, uint32_t count) {
+    if (!resect_reader_check_range(reader, first, (uint64_t) TYPE_METHOD_RECORD_SIZE * count)) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t offset = first + i * TYPE_METHOD_RECORD_SIZE;
+        resect_type_method method = resect_allocate(sizeof(struct P_resect_type_method));
+        method->id = resect_reader_string(reader, resect_reader_value(reader, offset));
+        method->name = resect_reader_string(reader, resect_reader_value(reader, offset + 1));
+        method->mangling = resect_reader_string(reader, resect_reader_value(reader, offset + 2));
+        method->source = resect_reader_string(reader, resect_reader_value(reader, offset + 3));
+        method->type = resect_reader_type(reader, resect_reader_value(reader, offset + 4));
+        method->decl = resect_reader_decl(reader, resect_reader_value(reader, offset + 5));
+        method->is_static = resect_reader_value(reader, offset + 6);
+        method->is_const = resect_reader_value(reader, offset + 7);
+        method->constructor_kind = resect_reader_value(reader, offset + 8);
+        resect_collection_add(type->methods, method);
+    }
+}
+
+static uint32_t resect_type_data_serialize(resect_type type, resect_writer writer) {
+    if (type->data == NULL) {
+        return RESECT_NO_REF;
+    }
+
+    uint32_t values[4];
+    uint32_t count = 0;
+
+    switch (type->kind) {
+        case RESECT_TYPE_KIND_FUNCTIONNOPROTO:
+        case RESECT_TYPE_KIND_FUNCTIONPROTO: {
+            resect_function_proto_data data = type->data;
+            values[0] = resect_writer_type(writer, data->result_type);
+            values[1] = data->variadic;
+            values[2] = resect_writer_type_collection(writer, data->parameters);
+            values[3] = resect_collection_size(data->parameters);
+            count = 4;
+        }
+        break;
+        default:
+            switch (type->category) {
+                case RESECT_TYPE_CATEGORY_POINTER: {
+                    resect_pointer_data data = type->data;
+                    values[0] = resect_writer_type(writer, data->type);
+                    values[1] = resect_writer_type(writer, data->member_owner);
+                    count = 2;
+                }
+                break;
+                case RESECT_TYPE_CATEGORY_REFERENCE: {
+                    resect_reference_data data = type->data;
+                    values[0] = resect_writer_type(writer, data->type);
+                    values[1] = data->is_lvalue;
+                    count = 2;
+                }
+                break;
+                case RESECT_TYPE_CATEGORY_ARRAY: {
+                    resect_array_data data = type->data;
+                    values[0] = resect_writer_type(writer, data->type);
+                    values[1] = RESECT_LOW_BITS(data->size);
+                    values[2] = RESECT_HIGH_BITS(data->size);
+                    count = 3;
+                }
+                break;
+                default:
+                    return RESECT_NO_REF;
+            }
+    }
+
+    return resect_writer_block(writer, values, count);
+}
+
+static void resect_type_data_deserialize(resect_type type, resect_reader reader, uint32_t offset) {
+    switch (type->kind) {
+        case RESECT_TYPE_KIND_FUNCTIONNOPROTO:
+        case RESECT_TYPE_KIND_FUNCTIONPROTO: {
+            resect_function_proto_data data = resect_allocate(sizeof(struct P_resect_function_proto_data));
+            data->result_type = resect_reader_type(reader, resect_reader_value(reader, offset));
+            data->variadic = resect_reader_value(reader, offset + 1);
+            data->parameters = resect_collection_create();
+            resect_reader_type_collection(reader,
+                                          resect_reader_value(reader, offset + 2),
+                                          resect_reader_value(reader, offset + 3),
+                                          data->parameters);
+
+            type->data_deallocator = resect_function_proto_free;
+            type->data = data;
+        }
+        break;
+        default:
+            switch (type->category) {
+                case RESECT_TYPE_CATEGORY_POINTER: {
+                    resect_pointer_data data = resect_allocate(sizeof(struct P_resect_pointer_data));
+                    data->type = resect_reader_type(reader, resect_reader_value(reader, offset));
+                    data->member_owner = resect_reader_type(reader, resect_reader_value(reader, offset + 1));
+
+                    type->data_deallocator = resect_pointer_data_free;
+                    type->data = data;
+                }
+                break;
+                case RESECT_TYPE_CATEGORY_REFERENCE: {
+                    resect_reference_data data = resect_allocate(sizeof(struct P_resect_reference_data));
+                    data->type = resect_reader_type(reader, resect_reader_value(reader, offset));
+                    data->is_lvalue = resect_reader_value(reader, offset + 1);
+
+                    type->data_deallocator = resect_reference_data_free;
+                    type->data = data;
+                }
+                break;
+                case RESECT_TYPE_CATEGORY_ARRAY: {
+                    resect_array_data data = resect_allocate(sizeof(struct P_resect_array_data));
+                    data->type = resect_reader_type(reader, resect_reader_value(reader, offset));
+                    data->size = (long long) RESECT_JOIN_BITS(resect_reader_value(reader, offset + 1),
+                                                              resect_reader_value(reader, offset + 2));
+
+                    type->data_deallocator = resect_array_data_free;
+                    type->data = data;
+                }
+                break;
+                default:
+                    break;
+            }
+    }
+}
+
+void resect_type_serialize(resect_type type, resect_writer writer, uint32_t *record) {
+    record[RESECT_TYPE_RECORD_KIND] = type->kind;
+    record[RESECT_TYPE_RECORD_NAME] = resect_writer_string(writer, type->name);
+    record[RESECT_TYPE_RECORD_SIZEOF_LOW] = RESECT_LOW_BITS(type->size);
+    record[RESECT_TYPE_RECORD_SIZEOF_HIGH] = RESECT_HIGH_BITS(type->size);
+    record[RESECT_TYPE_RECORD_ALIGNOF_LOW] = RESECT_LOW_BITS(type->alignment);
+    record[RESECT_TYPE_RECORD_ALIGNOF_HIGH] = RESECT_HIGH_BITS(type->alignment);
+    record[RESECT_TYPE_RECORD_CATEGORY] = type->category;
+    record[RESECT_TYPE_RECORD_FLAGS] = (type->const_qualified ? RESECT_TYPE_RECORD_FLAG_CONST_QUALIFIED : 0)
+                                       | (type->pod ? RESECT_TYPE_RECORD_FLAG_POD : 0)
+                                       | (type->undeclared ? RESECT_TYPE_RECORD_FLAG_UNDECLARED : 0)
+                                       | (type->truncated ? RESECT_TYPE_RECORD_FLAG_TRUNCATED : 0)
+                                       | (type->opaque ? RESECT_TYPE_RECORD_FLAG_OPAQUE : 0);
+    record[RESECT_TYPE_RECORD_DECL] = resect_writer_decl(writer, type->decl);
+
+    record[RESECT_TYPE_RECORD_FIELDS] = resect_type_fields_serialize(type, writer);
+    record[RESECT_TYPE_RECORD_FIELD_COUNT] = resect_collection_size(type->fields);
+
+    record[RESECT_TYPE_RECORD_BASE_CLASSES] = resect_writer_type_collection(writer, type->base_classes);
+    record[RESECT_TYPE_RECORD_BASE_CLASS_COUNT] = resect_collection_size(type->base_classes);
+
+    record[RESECT_TYPE_RECORD_METHODS] = resect_type_methods_serialize(type, writer);
+    record[RESECT_TYPE_RECORD_METHOD_COUNT] = resect_collection_size(type->methods);
+
+    record[RESECT_TYPE_RECORD_TEMPLATE_ARGUMENTS] =
+            resect_template_argument_collection_serialize(type->template_arguments, writer);
+    record[RESECT_TYPE_RECORD_TEMPLATE_ARGUMENT_COUNT] = resect_collection_size(type->template_arguments);
+
+    record[RESECT_TYPE_RECORD_DATA] = resect_type_data_serialize(type, writer);
+}
+
+void resect_type_deserialize(resect_type type, resect_reader reader, const uint32_t *record) {
+    type->kind = record[RESECT_TYPE_RECORD_KIND];
+    type->name = resect_reader_string(reader, record[RESECT_TYPE_RECORD_NAME]);
+    type->size = (long long) RESECT_JOIN_BITS(record[RESECT_TYPE_RECORD_SIZEOF_LOW],
+                                              record[RESECT_TYPE_RECORD_SIZEOF_HIGH]);
+    type->alignment = (long long) RESECT_JOIN_BITS(record[RESECT_TYPE_RECORD_ALIGNOF_LOW],
+                                                   record[RESECT_TYPE_RECORD_ALIGNOF_HIGH]);
+    type->category = record[RESECT_TYPE_RECORD_CATEGORY];
+    type->const_qualified =
+            convert_bool_from_uint(record[RESECT_TYPE_RECORD_FLAGS] & RESECT_TYPE_RECORD_FLAG_CONST_QUALIFIED);
+    type->pod = convert_bool_from_uint(record[RESECT_TYPE_RECORD_FLAGS] & RESECT_TYPE_RECORD_FLAG_POD);
+    type->undeclared = convert_bool_from_uint(record[RESECT_TYPE_RECORD_FLAGS] & RESECT_TYPE_RECORD_FLAG_UNDECLARED);
+    type->truncated = convert_bool_from_uint(record[RESECT_TYPE_RECORD_FLAGS] & RESECT_TYPE_RECORD_FLAG_TRUNCATED);
+    type->opaque = convert_bool_from_uint(record[RESECT_TYPE_RECORD_FLAGS] & RESECT_TYPE_RECORD_FLAG_OPAQUE);
+    type->decl = resect_reader_decl(reader, record[RESECT_TYPE_RECORD_DECL]);
+
+    type->fields = resect_collection_create();
+    resect_type_fields_deserialize(type, reader,
+                                   record[RESECT_TYPE_RECORD_FIELDS],
+                                   record[RESECT_TYPE_RECORD_FIELD_COUNT]);
+
+    type->base_classes = resect_collection_create();
+    resect_reader_type_collection(reader,
+                                  record[RESECT_TYPE_RECORD_BASE_CLASSES],
+                                  record[RESECT_TYPE_RECORD_BASE_CLASS_COUNT],
+                                  type->base_classes);
+
+    type->methods = resect_collection_create();
+    resect_type_methods_deserialize(type, reader,
+                                    record[RESECT_TYPE_RECORD_METHODS],
+                                    record[RESECT_TYPE_RECORD_METHOD_COUNT]);
+
+    type->template_arguments = resect_collection_create();
+    resect_template_argument_collection_deserialize(type->template_arguments, reader,
+                                                    record[RESECT_TYPE_RECORD_TEMPLATE_ARGUMENTS],
+                                                    record[RESECT_TYPE_RECORD_TEMPLATE_ARGUMENT_COUNT]);
+
+    type->data_deallocator = NULL;
+    type->data = NULL;
+    resect_type_data_deserialize(type, reader, record[RESECT_TYPE_RECORD_DATA]);
+
+    type->initialized = true;
+}
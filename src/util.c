@@ -4,13 +4,223 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "resect_private.h"
+
+#define uthash_malloc(sz) resect_allocate(sz)
+#define uthash_free(ptr, sz) resect_deallocate(ptr)
 #include "uthash.h"
 
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <pthread.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
 #define PCRE2_CODE_UNIT_WIDTH 8
 #include <pcre2.h>
 
+/*
+ * ALLOCATOR
+ */
+// keeps user blocks aligned the same way malloc does
+typedef union {
+    struct {
+        size_t size;
+        // id of the memory account charged for the block, 0 if none was
+        unsigned long long account;
+    } block;
+    long double long_double_value;
+    long long long_value;
+    void *pointer_value;
+} resect_allocation_header;
+
+#if defined(_MSC_VER)
+#  define RESECT_THREAD_LOCAL __declspec(thread)
+#else
+#  define RESECT_THREAD_LOCAL __thread
+#endif
+
+struct P_resect_memory_account {
+    unsigned long long id;
+    volatile long long allocated;
+};
+
+static RESECT_THREAD_LOCAL resect_memory_account current_account = NULL;
+
+static void *default_malloc(size_t size, void *user_data) { return malloc(size); }
+
+static void *default_realloc(void *ptr, size_t size, void *user_data) { return realloc(ptr, size); }
+
+static void default_free(void *ptr, void *user_data) { free(ptr); }
+
+static struct {
+    resect_malloc_fn malloc_fn;
+    resect_realloc_fn realloc_fn;
+    resect_free_fn free_fn;
+    void *user_data;
+
+    volatile long long allocated;
+    volatile long long peak;
+    volatile long long total;
+} allocator = {
+    .malloc_fn = default_malloc,
+    .realloc_fn = default_realloc,
+    .free_fn = default_free,
+    .user_data = NULL,
+    .allocated = 0,
+    .peak = 0,
+    .total = 0,
+};
+
+static long long atomic_add(volatile long long *value, long long amount) {
+#if defined(_WIN32)
+    return InterlockedExchangeAdd64(value, amount) + amount;
+#else
+    return __atomic_add_fetch(value, amount, __ATOMIC_RELAXED);
+#endif
+}
+
+static long long atomic_load(volatile long long *value) {
+#if defined(_WIN32)
+    return InterlockedCompareExchange64(value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+#endif
+}
+
+static void atomic_max(volatile long long *value, long long candidate) {
+    long long current = atomic_load(value);
+    while (current < candidate) {
+#if defined(_WIN32)
+        long long previous = InterlockedCompareExchange64(value, candidate, current);
+        if (previous == current) {
+            return;
+        }
+        current = previous;
+#else
+        if (__atomic_compare_exchange_n(value, &current, candidate, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return;
+        }
+#endif
+    }
+}
+
+static void track_allocation(long long amount) {
+    if (amount > 0) {
+        atomic_add(&allocator.total, amount);
+    }
+    atomic_max(&allocator.peak, atomic_add(&allocator.allocated, amount));
+}
+
+resect_bool resect_set_allocator(resect_malloc_fn malloc_fn, resect_realloc_fn realloc_fn, resect_free_fn free_fn,
+                                 void *user_data) {
+    if (atomic_load(&allocator.allocated) != 0) {
+        // live blocks would end up released through a free function that didn't allocate them
+        return resect_false;
+    }
+
+    if (malloc_fn == NULL || realloc_fn == NULL || free_fn == NULL) {
+        malloc_fn = default_malloc;
+        realloc_fn = default_realloc;
+        free_fn = default_free;
+        user_data = NULL;
+    }
+    allocator.malloc_fn = malloc_fn;
+    allocator.realloc_fn = realloc_fn;
+    allocator.free_fn = free_fn;
+    allocator.user_data = user_data;
+    return resect_true;
+}
+
+static void charge_account(resect_allocation_header *header, long long amount) {
+    // blocks released by threads working for another account are not uncharged, so the budget of one
+    // translation context is never affected by others running concurrently
+    if (current_account != NULL && current_account->id == header->block.account) {
+        atomic_add(&current_account->allocated, amount);
+    }
+}
+
+unsigned long long resect_allocated_bytes() { return (unsigned long long) atomic_load(&allocator.allocated); }
+
+unsigned long long resect_peak_allocated_bytes() { return (unsigned long long) atomic_load(&allocator.peak); }
+
+unsigned long long resect_total_allocated_bytes() { return (unsigned long long) atomic_load(&allocator.total); }
+
+void *resect_allocate(size_t size) {
+    resect_allocation_header *header = allocator.malloc_fn(sizeof(resect_allocation_header) + size,
+                                                           allocator.user_data);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->block.size = size;
+    header->block.account = current_account != NULL ? current_account->id : 0;
+    charge_account(header, (long long) size);
+    track_allocation((long long) size);
+    return header + 1;
+}
+
+void *resect_reallocate(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return resect_allocate(size);
+    }
+
+    resect_allocation_header *header = (resect_allocation_header *) ptr - 1;
+    size_t old_size = header->block.size;
+    header = allocator.realloc_fn(header, sizeof(resect_allocation_header) + size, allocator.user_data);
+    if (header == NULL) {
+        return NULL;
+    }
+    header->block.size = size;
+    charge_account(header, (long long) size - (long long) old_size);
+    track_allocation((long long) size - (long long) old_size);
+    return header + 1;
+}
+
+void resect_deallocate(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    resect_allocation_header *header = (resect_allocation_header *) ptr - 1;
+    charge_account(header, -(long long) header->block.size);
+    track_allocation(-(long long) header->block.size);
+    allocator.free_fn(header, allocator.user_data);
+}
+
+resect_memory_account resect_memory_account_create() {
+    static volatile long long last_account_id = 0;
+
+    resect_memory_account account = resect_allocate(sizeof(struct P_resect_memory_account));
+    account->id = (unsigned long long) atomic_add(&last_account_id, 1);
+    account->allocated = 0;
+    return account;
+}
+
+void resect_memory_account_free(resect_memory_account account) {
+    resect_deallocate(account);
+}
+
+resect_memory_account resect_memory_account_switch(resect_memory_account account) {
+    resect_memory_account previous = current_account;
+    current_account = account;
+    return previous;
+}
+
+unsigned long long resect_memory_account_allocated(resect_memory_account account) {
+    long long allocated = atomic_load(&account->allocated);
+    return allocated > 0 ? (unsigned long long) allocated : 0;
+}
+
+static void *pcre_allocate(size_t size, void *data) { return resect_allocate(size); }
+
+static void pcre_deallocate(void *ptr, void *data) { resect_deallocate(ptr); }
+
 /*
  * STRING
  */
@@ -20,16 +230,16 @@ struct P_resect_string {
 };
 
 resect_string resect_string_create(unsigned int initial_capacity) {
-    resect_string result = malloc(sizeof(struct P_resect_string));
+    resect_string result = resect_allocate(sizeof(struct P_resect_string));
     result->capacity = initial_capacity > 0 ? initial_capacity : 1;
-    result->value = malloc(result->capacity * sizeof(char));
+    result->value = resect_allocate(result->capacity * sizeof(char));
     result->value[0] = 0;
     return result;
 }
 
 void resect_string_free(resect_string string) {
-    free(string->value);
-    free(string);
+    resect_deallocate(string->value);
+    resect_deallocate(string);
 }
 
 const char *resect_string_to_c(resect_string string) {
@@ -43,10 +253,10 @@ void resect_ensure_string_capacity(resect_string string, unsigned long new_capac
         size_t old_capacity = string->capacity;
 
 
-        char *new_value = malloc(sizeof(char) * new_capacity);
+        char *new_value = resect_allocate(sizeof(char) * new_capacity);
         assert(new_value);
         memcpy(new_value, old_string, sizeof(char) * old_capacity);
-        free(old_string);
+        resect_deallocate(old_string);
 
         string->capacity = new_capacity;
         string->value = new_value;
@@ -184,7 +394,7 @@ struct P_resect_collection {
 };
 
 resect_collection resect_collection_create() {
-    resect_collection collection = malloc(sizeof(struct P_resect_collection));
+    resect_collection collection = resect_allocate(sizeof(struct P_resect_collection));
     collection->head = NULL;
     collection->tail = NULL;
     collection->size = 0;
@@ -196,14 +406,14 @@ void resect_collection_free(resect_collection collection) {
     el = collection->head;
     while (el) {
         next = el->next;
-        free(el);
+        resect_deallocate(el);
         el = next;
     }
-    free(collection);
+    resect_deallocate(collection);
 }
 
 void resect_collection_add(resect_collection collection, void *value) {
-    struct P_resect_collection_element *element = malloc(sizeof(struct P_resect_collection_element));
+    struct P_resect_collection_element *element = resect_allocate(sizeof(struct P_resect_collection_element));
     element->value = value;
     element->next = NULL;
     element->prev = NULL;
@@ -226,13 +436,13 @@ void *resect_collection_pop_last(resect_collection collection) {
     }
     void *result = collection->tail->value;
     if (collection->tail->prev == NULL) {
-        free(collection->tail);
+        resect_deallocate(collection->tail);
 
         collection->head = NULL;
         collection->tail = NULL;
     } else {
         struct P_resect_collection_element *new_tail = collection->tail->prev;
-        free(collection->tail);
+        resect_deallocate(collection->tail);
 
         new_tail->next = NULL;
         collection->tail = new_tail;
@@ -250,6 +460,29 @@ void *resect_collection_peek_last(resect_collection collection) {
 
 unsigned int resect_collection_size(resect_collection collection) { return collection->size; }
 
+/**
+ * @param compare qsort-style comparator receiving pointers to collection values
+ */
+void resect_collection_sort(resect_collection collection, int (*compare)(const void *, const void *)) {
+    if (collection->size < 2) {
+        return;
+    }
+
+    void **values = resect_allocate(collection->size * sizeof(void *));
+    unsigned int i = 0;
+    for (struct P_resect_collection_element *el = collection->head; el != NULL; el = el->next) {
+        values[i++] = el->value;
+    }
+
+    qsort(values, collection->size, sizeof(void *), compare);
+
+    i = 0;
+    for (struct P_resect_collection_element *el = collection->head; el != NULL; el = el->next) {
+        el->value = values[i++];
+    }
+    resect_deallocate(values);
+}
+
 /*
  * ITERATOR
  */
@@ -259,7 +492,7 @@ struct P_resect_iterator {
 };
 
 resect_iterator resect_collection_iterator(resect_collection collection) {
-    resect_iterator iterator = malloc(sizeof(struct P_resect_iterator));
+    resect_iterator iterator = resect_allocate(sizeof(struct P_resect_iterator));
     iterator->head = collection->head;
     iterator->current = NULL;
     return iterator;
@@ -285,7 +518,7 @@ void *resect_iterator_value(resect_iterator iter) {
     return iter->current->value;
 }
 
-void resect_iterator_free(resect_iterator iter) { free(iter); }
+void resect_iterator_free(resect_iterator iter) { resect_deallocate(iter); }
 
 /*
  * SET
@@ -301,7 +534,7 @@ struct P_resect_set {
 };
 
 resect_set resect_set_create() {
-    resect_set set = malloc(sizeof(struct P_resect_set));
+    resect_set set = resect_allocate(sizeof(struct P_resect_set));
     set->head = NULL;
     return set;
 }
@@ -316,7 +549,7 @@ resect_bool resect_set_contains(resect_set set, void *value) {
 
 resect_bool resect_set_add(resect_set set, void *value) {
     if (!resect_set_contains(set, value)) {
-        resect_set_item entry = malloc(sizeof(struct P_resect_set_item));
+        resect_set_item entry = resect_allocate(sizeof(struct P_resect_set_item));
         entry->key = value;
         HASH_ADD_PTR(set->head, key, entry);
         return resect_true;
@@ -324,13 +557,24 @@ resect_bool resect_set_add(resect_set set, void *value) {
     return resect_false;
 }
 
+resect_bool resect_set_remove(resect_set set, void *value) {
+    resect_set_item entry;
+    HASH_FIND_PTR(set->head, &value, entry);
+    if (entry == NULL) {
+        return resect_false;
+    }
+    HASH_DEL(set->head, entry);
+    resect_deallocate(entry);
+    return resect_true;
+}
+
 void resect_set_free(resect_set set) {
     struct P_resect_set_item *element, *tmp;
     HASH_ITER(hh, set->head, element, tmp) {
         HASH_DEL(set->head, element);
-        free(element);
+        resect_deallocate(element);
     }
-    free(set);
+    resect_deallocate(set);
 }
 
 void resect_set_add_to_collection(resect_set set, resect_collection collection) {
@@ -353,6 +597,57 @@ void resect_visit_set(resect_set set, resect_bool (*item_visitor)(void *ctx, voi
     }
 }
 
+/*
+ * POINTER TABLE
+ */
+typedef struct P_resect_pointer_table_entry {
+    void *key;
+    void *value;
+
+    UT_hash_handle hh;
+} *resect_pointer_table_entry;
+
+struct P_resect_pointer_table {
+    resect_pointer_table_entry head;
+};
+
+resect_pointer_table resect_pointer_table_create() {
+    resect_pointer_table table = resect_allocate(sizeof(struct P_resect_pointer_table));
+    table->head = NULL;
+    return table;
+}
+
+resect_bool resect_pointer_table_put_if_absent(resect_pointer_table table, void *key, void *value) {
+    resect_pointer_table_entry entry;
+    HASH_FIND_PTR(table->head, &key, entry);
+    if (entry != NULL) {
+        return resect_false;
+    }
+
+    entry = resect_allocate(sizeof(struct P_resect_pointer_table_entry));
+    entry->key = key;
+    entry->value = value;
+    HASH_ADD_PTR(table->head, key, entry);
+    return resect_true;
+}
+
+void *resect_pointer_table_get(resect_pointer_table table, void *key) {
+    resect_pointer_table_entry entry;
+    HASH_FIND_PTR(table->head, &key, entry);
+    return entry != NULL ? entry->value : NULL;
+}
+
+unsigned int resect_pointer_table_size(resect_pointer_table table) { return HASH_COUNT(table->head); }
+
+void resect_pointer_table_free(resect_pointer_table table) {
+    struct P_resect_pointer_table_entry *entry, *tmp;
+    HASH_ITER(hh, table->head, entry, tmp) {
+        HASH_DEL(table->head, entry);
+        resect_deallocate(entry);
+    }
+    resect_deallocate(table);
+}
+
 /*
  * STRING HASH TABLE
  */
@@ -368,7 +663,7 @@ struct P_resect_table {
 };
 
 resect_table resect_table_create() {
-    resect_table table = malloc(sizeof(struct P_resect_table));
+    resect_table table = resect_allocate(sizeof(struct P_resect_table));
     table->head = NULL;
     return table;
 }
@@ -380,11 +675,11 @@ resect_bool resect_table_put_if_absent(resect_table table, const char *key, void
         return resect_false;
     }
 
-    entry = malloc(sizeof(struct P_resect_table_entry));
+    entry = resect_allocate(sizeof(struct P_resect_table_entry));
     entry->value = value;
 
     size_t key_len = strlen(key);
-    entry->key = malloc(sizeof(char) * (key_len + 1));
+    entry->key = resect_allocate(sizeof(char) * (key_len + 1));
     strcpy(entry->key, key);
 
     HASH_ADD_STR(table->head, key, entry);
@@ -393,11 +688,11 @@ resect_bool resect_table_put_if_absent(resect_table table, const char *key, void
 
 void *resect_table_put(resect_table table, const char *key, void *value) {
     struct P_resect_table_entry *new_entry = NULL;
-    new_entry = malloc(sizeof(struct P_resect_table_entry));
+    new_entry = resect_allocate(sizeof(struct P_resect_table_entry));
     new_entry->value = value;
 
     size_t key_len = strlen(key);
-    new_entry->key = malloc(sizeof(char) * (key_len + 1));
+    new_entry->key = resect_allocate(sizeof(char) * (key_len + 1));
     strcpy(new_entry->key, key);
 
     struct P_resect_table_entry *prev_entry = NULL;
@@ -406,8 +701,8 @@ void *resect_table_put(resect_table table, const char *key, void *value) {
     void *prev_value = NULL;
     if (prev_entry != NULL) {
         prev_value = prev_entry->value;
-        free(prev_entry->key);
-        free(prev_entry);
+        resect_deallocate(prev_entry->key);
+        resect_deallocate(prev_entry);
     }
 
     return prev_value;
@@ -421,8 +716,8 @@ bool resect_table_remove(resect_table table, const char *key) {
     }
 
     HASH_DEL(table->head, entry);
-    free(entry->key);
-    free(entry);
+    resect_deallocate(entry->key);
+    resect_deallocate(entry);
     return true;
 }
 
@@ -466,10 +761,306 @@ void resect_table_free(resect_table table, void (*value_destructor)(void *, void
         if (value_destructor != NULL) {
             value_destructor(context, entry->value);
         }
-        free(entry->key);
-        free(entry);
+        resect_deallocate(entry->key);
+        resect_deallocate(entry);
+    }
+    resect_deallocate(table);
+}
+
+/*
+ * ATOMICS
+ */
+unsigned int resect_load_acquire(volatile unsigned int *value) {
+#if defined(_WIN32)
+    return (unsigned int) InterlockedCompareExchange((volatile LONG *) value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void resect_store_release(volatile unsigned int *value, unsigned int new_value) {
+#if defined(_WIN32)
+    InterlockedExchange((volatile LONG *) value, (LONG) new_value);
+#else
+    __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+#endif
+}
+
+/*
+ * MUTEX
+ */
+struct P_resect_mutex {
+#if defined(_WIN32)
+    CRITICAL_SECTION handle;
+#else
+    pthread_mutex_t handle;
+#endif
+};
+
+resect_mutex resect_mutex_create() {
+    resect_mutex mutex = resect_allocate(sizeof(struct P_resect_mutex));
+#if defined(_WIN32)
+    InitializeCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_init(&mutex->handle, NULL);
+#endif
+    return mutex;
+}
+
+void resect_mutex_lock(resect_mutex mutex) {
+#if defined(_WIN32)
+    EnterCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_lock(&mutex->handle);
+#endif
+}
+
+void resect_mutex_unlock(resect_mutex mutex) {
+#if defined(_WIN32)
+    LeaveCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_unlock(&mutex->handle);
+#endif
+}
+
+void resect_mutex_free(resect_mutex mutex) {
+#if defined(_WIN32)
+    DeleteCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_destroy(&mutex->handle);
+#endif
+    resect_deallocate(mutex);
+}
+
+/*
+ * CONDITION
+ */
+struct P_resect_condition {
+#if defined(_WIN32)
+    CONDITION_VARIABLE handle;
+#else
+    pthread_cond_t handle;
+#endif
+};
+
+resect_condition resect_condition_create() {
+    resect_condition condition = resect_allocate(sizeof(struct P_resect_condition));
+#if defined(_WIN32)
+    InitializeConditionVariable(&condition->handle);
+#else
+    pthread_cond_init(&condition->handle, NULL);
+#endif
+    return condition;
+}
+
+void resect_condition_wait(resect_condition condition, resect_mutex mutex) {
+#if defined(_WIN32)
+    SleepConditionVariableCS(&condition->handle, &mutex->handle, INFINITE);
+#else
+    pthread_cond_wait(&condition->handle, &mutex->handle);
+#endif
+}
+
+void resect_condition_broadcast(resect_condition condition) {
+#if defined(_WIN32)
+    WakeAllConditionVariable(&condition->handle);
+#else
+    pthread_cond_broadcast(&condition->handle);
+#endif
+}
+
+void resect_condition_free(resect_condition condition) {
+#if defined(_WIN32)
+    // condition variables need no cleanup on windows
+#else
+    pthread_cond_destroy(&condition->handle);
+#endif
+    resect_deallocate(condition);
+}
+
+/*
+ * CONCURRENT HASH TABLE
+ */
+#define RESECT_CONCURRENT_TABLE_SHARD_COUNT 16
+
+struct P_resect_concurrent_table_shard {
+    // NULL if the table is used by a single thread
+    resect_mutex lock;
+    resect_table table;
+};
+
+struct P_resect_concurrent_table {
+    struct P_resect_concurrent_table_shard shards[RESECT_CONCURRENT_TABLE_SHARD_COUNT];
+};
+
+static struct P_resect_concurrent_table_shard *find_shard(resect_concurrent_table table, const char *key) {
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (const char *c = key; *c != '\0'; ++c) {
+        hash = (hash ^ (unsigned char) *c) * 16777619u;
+    }
+    return &table->shards[hash % RESECT_CONCURRENT_TABLE_SHARD_COUNT];
+}
+
+static void lock_shard(struct P_resect_concurrent_table_shard *shard) {
+    if (shard->lock != NULL) {
+        resect_mutex_lock(shard->lock);
+    }
+}
+
+static void unlock_shard(struct P_resect_concurrent_table_shard *shard) {
+    if (shard->lock != NULL) {
+        resect_mutex_unlock(shard->lock);
+    }
+}
+
+resect_concurrent_table resect_concurrent_table_create(bool synchronized) {
+    resect_concurrent_table table = resect_allocate(sizeof(struct P_resect_concurrent_table));
+    for (int i = 0; i < RESECT_CONCURRENT_TABLE_SHARD_COUNT; ++i) {
+        table->shards[i].lock = synchronized ? resect_mutex_create() : NULL;
+        table->shards[i].table = resect_table_create();
+    }
+    return table;
+}
+
+void *resect_concurrent_table_put_if_absent(resect_concurrent_table table, const char *key, void *value) {
+    struct P_resect_concurrent_table_shard *shard = find_shard(table, key);
+
+    lock_shard(shard);
+    void *existing = resect_table_get(shard->table, key);
+    if (existing == NULL) {
+        resect_table_put_if_absent(shard->table, key, value);
+    }
+    unlock_shard(shard);
+
+    return existing != NULL ? existing : value;
+}
+
+void *resect_concurrent_table_get(resect_concurrent_table table, const char *key) {
+    struct P_resect_concurrent_table_shard *shard = find_shard(table, key);
+
+    lock_shard(shard);
+    void *value = resect_table_get(shard->table, key);
+    unlock_shard(shard);
+
+    return value;
+}
+
+bool resect_concurrent_table_remove(resect_concurrent_table table, const char *key) {
+    struct P_resect_concurrent_table_shard *shard = find_shard(table, key);
+
+    lock_shard(shard);
+    bool removed = resect_table_remove(shard->table, key);
+    unlock_shard(shard);
+
+    return removed;
+}
+
+unsigned int resect_concurrent_table_size(resect_concurrent_table table) {
+    unsigned int size = 0;
+    for (int i = 0; i < RESECT_CONCURRENT_TABLE_SHARD_COUNT; ++i) {
+        lock_shard(&table->shards[i]);
+        size += resect_table_size(table->shards[i].table);
+        unlock_shard(&table->shards[i]);
+    }
+    return size;
+}
+
+/**
+ * Visits shards one after another, each shard is locked while it's being visited.
+ *
+ * @param entry_visitor return false to unterrupt visit process
+ * @param context visit data passed to entry_visitor
+ */
+void resect_visit_concurrent_table(resect_concurrent_table table,
+                                   resect_bool (*entry_visitor)(void *, const char *, void *),
+                                   void *context) {
+    assert(entry_visitor != NULL);
+    for (int i = 0; i < RESECT_CONCURRENT_TABLE_SHARD_COUNT; ++i) {
+        struct P_resect_concurrent_table_shard *shard = &table->shards[i];
+        bool interrupted = false;
+
+        lock_shard(shard);
+        struct P_resect_table_entry *entry, *tmp;
+        HASH_ITER(hh, shard->table->head, entry, tmp) {
+            if (!entry_visitor(context, entry->key, entry->value)) {
+                interrupted = true;
+                break;
+            }
+        }
+        unlock_shard(shard);
+
+        if (interrupted) {
+            break;
+        }
     }
-    free(table);
+}
+
+void resect_concurrent_table_free(resect_concurrent_table table, void (*value_destructor)(void *, void *),
+                                  void *context) {
+    for (int i = 0; i < RESECT_CONCURRENT_TABLE_SHARD_COUNT; ++i) {
+        resect_table_free(table->shards[i].table, value_destructor, context);
+        if (table->shards[i].lock != NULL) {
+            resect_mutex_free(table->shards[i].lock);
+        }
+    }
+    resect_deallocate(table);
+}
+
+/*
+ * THREAD
+ */
+struct P_resect_thread {
+    void (*routine)(void *);
+    void *data;
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+};
+
+#if defined(_WIN32)
+static DWORD WINAPI run_thread(LPVOID data) {
+    resect_thread thread = data;
+    thread->routine(thread->data);
+    return 0;
+}
+#else
+static void *run_thread(void *data) {
+    resect_thread thread = data;
+    thread->routine(thread->data);
+    return NULL;
+}
+#endif
+
+resect_thread resect_thread_create(void (*routine)(void *), void *data) {
+    resect_thread thread = resect_allocate(sizeof(struct P_resect_thread));
+    thread->routine = routine;
+    thread->data = data;
+#if defined(_WIN32)
+    thread->handle = CreateThread(NULL, 0, run_thread, thread, 0, NULL);
+    if (thread->handle == NULL) {
+        resect_deallocate(thread);
+        return NULL;
+    }
+#else
+    if (pthread_create(&thread->handle, NULL, run_thread, thread) != 0) {
+        resect_deallocate(thread);
+        return NULL;
+    }
+#endif
+    return thread;
+}
+
+void resect_thread_join(resect_thread thread) {
+#if defined(_WIN32)
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+    resect_deallocate(thread);
 }
 
 /*
@@ -490,12 +1081,20 @@ resect_pattern resect_pattern_create(resect_string pattern) {
 }
 
 resect_pattern resect_pattern_create_c(const char *pattern) {
-    resect_pattern result = malloc(sizeof(struct P_resect_pattern));
+    resect_pattern result = resect_allocate(sizeof(struct P_resect_pattern));
+
+    // compiled code remembers allocator it was compiled with and uses it for match data as well
+    pcre2_general_context *general_context = pcre2_general_context_create(pcre_allocate, pcre_deallocate, NULL);
+    pcre2_compile_context *compile_context = pcre2_compile_context_create(general_context);
 
     int errornumber;
     PCRE2_SIZE erroroffset;
     pcre2_code *compiled = pcre2_compile((PCRE2_SPTR) (pattern), PCRE2_ZERO_TERMINATED, PCRE2_UTF,
-                                         &errornumber, &erroroffset, NULL);
+                                         &errornumber, &erroroffset, compile_context);
+
+    pcre2_compile_context_free(compile_context);
+    pcre2_general_context_free(general_context);
+
     if (compiled == NULL) {
         print_pcre_error(errornumber, erroroffset);
         // FIXME: add better error reporting
@@ -561,7 +1160,162 @@ done:
 
 void resect_pattern_free(resect_pattern pattern) {
     pcre2_code_free(pattern->compiled);
-    free(pattern);
+    resect_deallocate(pattern);
+}
+
+/*
+ * STATS
+ */
+struct P_resect_stats {
+    double wall_time[RESECT_PHASE_COUNT];
+    double cpu_time[RESECT_PHASE_COUNT];
+    double wall_start[RESECT_PHASE_COUNT];
+    double cpu_start[RESECT_PHASE_COUNT];
+    unsigned long long counters[RESECT_COUNTER_COUNT];
+};
+
+static double wall_clock() {
+#if defined(_WIN32)
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+#endif
+}
+
+static double cpu_clock() {
+    return (double) clock() / CLOCKS_PER_SEC;
+}
+
+resect_stats resect_stats_create() {
+    resect_stats stats = resect_allocate(sizeof(struct P_resect_stats));
+    resect_stats_reset(stats);
+    return stats;
+}
+
+void resect_stats_reset(resect_stats stats) {
+    memset(stats, 0, sizeof(struct P_resect_stats));
+}
+
+void resect_stats_phase_begin(resect_stats stats, resect_phase phase) {
+    stats->wall_start[phase] = wall_clock();
+    stats->cpu_start[phase] = cpu_clock();
+}
+
+void resect_stats_phase_end(resect_stats stats, resect_phase phase) {
+    stats->wall_time[phase] += wall_clock() - stats->wall_start[phase];
+    stats->cpu_time[phase] += cpu_clock() - stats->cpu_start[phase];
+}
+
+void resect_stats_count(resect_stats stats, resect_counter counter, unsigned long long amount) {
+    if (stats != NULL) {
+        stats->counters[counter] += amount;
+    }
+}
+
+double resect_stats_wall_time(resect_stats stats, resect_phase phase) { return stats->wall_time[phase]; }
+
+double resect_stats_cpu_time(resect_stats stats, resect_phase phase) { return stats->cpu_time[phase]; }
+
+unsigned long long resect_stats_counter(resect_stats stats, resect_counter counter) {
+    return stats->counters[counter];
+}
+
+void resect_stats_merge(resect_stats stats, resect_stats other) {
+    for (int counter = 0; counter < RESECT_COUNTER_COUNT; ++counter) {
+        stats->counters[counter] += other->counters[counter];
+    }
+}
+
+void resect_stats_free(resect_stats stats) { resect_deallocate(stats); }
+
+/*
+ * FILE MAPPING
+ */
+struct P_resect_file_mapping {
+    const void *data;
+    size_t size;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+resect_file_mapping resect_file_mapping_open(const char *path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return NULL;
+    }
+
+    resect_file_mapping result = resect_allocate(sizeof(struct P_resect_file_mapping));
+    result->data = data;
+    result->size = (size_t) file_size.QuadPart;
+    result->file = file;
+    result->mapping = mapping;
+    return result;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, (size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping stays valid after descriptor is closed
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    resect_file_mapping result = resect_allocate(sizeof(struct P_resect_file_mapping));
+    result->data = data;
+    result->size = (size_t) file_stat.st_size;
+    return result;
+#endif
+}
+
+const void *resect_file_mapping_data(resect_file_mapping mapping) { return mapping->data; }
+
+size_t resect_file_mapping_size(resect_file_mapping mapping) { return mapping->size; }
+
+void resect_file_mapping_close(resect_file_mapping mapping) {
+#if defined(_WIN32)
+    UnmapViewOfFile(mapping->data);
+    CloseHandle(mapping->mapping);
+    CloseHandle(mapping->file);
+#else
+    munmap((void *) mapping->data, mapping->size);
+#endif
+    resect_deallocate(mapping);
 }
 
 /*
@@ -808,4 +1562,16 @@ unsigned long resect_hash(const char *str) {
     return hash;
 }
 
+/**
+ * FNV-1a, 64 bits wide unlike resect_hash(), so it can tell file contents apart
+ */
+unsigned long long resect_hash_buffer(const void *data, size_t length) {
+    unsigned long long hash = 14695981039346656037ull;
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
 resect_bool convert_bool_from_uint(unsigned int val) { return val ? resect_true : resect_false; }
@@ -5,6 +5,10 @@
 #include <iostream>
 #include <memory>
 
+#define TESTO_VERSION (1 << 8 | 2)
+#define TESTO_NAME "testo"
+#define TESTO_BEGIN namespace Testo {
+
 
 namespace Andre {
   class Deig {
@@ -18,6 +22,10 @@ namespace Andre {
   };
 }
 namespace Testo {
+  static const char *GREETING = "Hello World!";
+
+  int counter = 42;
+
   class Testo {
   public:
     using WeakTopping = std::weak_ptr<Andre::Topping>;
@@ -44,7 +52,7 @@ namespace Testo {
   };
 
   void Testo::hei() {
-    std::cout << "Hello World!" << std::endl;
+    std::cout << GREETING << std::endl;
   }
 }
 #endif
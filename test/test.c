@@ -2,6 +2,7 @@
 // Created by borodust on 12/27/19.
 //
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "../resect.h"
 
@@ -93,6 +94,38 @@ void print_specializations(resect_decl decl) {
     resect_iterator_free(specialization_iter);
 }
 
+void print_variable_value(resect_decl decl) {
+    switch (resect_variable_get_kind(decl)) {
+        case RESECT_VARIABLE_TYPE_INT:
+            printf("   VALUE: %lld\n", resect_variable_get_value_as_int(decl));
+            break;
+        case RESECT_VARIABLE_TYPE_FLOAT:
+            printf("   VALUE: %f\n", resect_variable_get_value_as_float(decl));
+            break;
+        case RESECT_VARIABLE_TYPE_STRING:
+        case RESECT_VARIABLE_TYPE_OTHER:
+            printf("   VALUE: %s\n", resect_variable_get_value_as_string(decl));
+            break;
+        default:;
+    }
+}
+
+void print_macro_value(resect_decl decl) {
+    switch (resect_macro_get_value_kind(decl)) {
+        case RESECT_VARIABLE_TYPE_INT:
+            printf("   VALUE: %lld\n", resect_macro_get_value_as_int(decl));
+            break;
+        case RESECT_VARIABLE_TYPE_FLOAT:
+            printf("   VALUE: %f\n", resect_macro_get_value_as_float(decl));
+            break;
+        case RESECT_VARIABLE_TYPE_STRING:
+        case RESECT_VARIABLE_TYPE_OTHER:
+            printf("   VALUE: %s\n", resect_macro_get_value_as_string(decl));
+            break;
+        default:;
+    }
+}
+
 void print_location(resect_decl decl) {
     resect_location loc = resect_decl_get_location(decl);
     printf("  LOCATION: %s:%d\n", resect_location_name(loc), resect_location_line(loc));
@@ -110,9 +143,405 @@ void print_owner(resect_decl decl) {
     }
 }
 
-int main(int argc, char **argv) {
-    char *filename = argc > 1 ? argv[1] : "../test/Testo.hpp";
+int compare_mapped_decls(resect_translation_unit unit, resect_mapped_unit mapped) {
+    int mismatches = 0;
+    for (unsigned int i = 0; i < resect_mapped_unit_declaration_count(mapped); ++i) {
+        resect_mapped_decl mapped_decl = resect_mapped_unit_declaration(mapped, i);
+        const char *id = resect_mapped_decl_get_id(mapped, mapped_decl);
+        resect_decl decl = resect_unit_find_decl_by_id(unit, id);
+        if (decl == NULL) {
+            printf("MAPPED MISMATCH: %s not found\n", id);
+            ++mismatches;
+            continue;
+        }
+
+        resect_mapped_type mapped_type = resect_mapped_decl_get_type(mapped, mapped_decl);
+        resect_type type = resect_decl_get_type(decl);
+        if (resect_mapped_decl_get_kind(mapped, mapped_decl) != resect_decl_get_kind(decl)
+            || strcmp(resect_mapped_decl_get_name(mapped, mapped_decl), resect_decl_get_name(decl)) != 0
+            || strcmp(resect_mapped_decl_get_namespace(mapped, mapped_decl), resect_decl_get_namespace(decl)) != 0
+            || strcmp(resect_mapped_decl_get_mangled_name(mapped, mapped_decl), resect_decl_get_mangled_name(decl)) != 0
+            || resect_mapped_decl_get_location_line(mapped, mapped_decl) != resect_location_line(resect_decl_get_location(decl))
+            || (mapped_type == NULL) != (type == NULL)) {
+            printf("MAPPED MISMATCH: %s\n", id);
+            ++mismatches;
+            continue;
+        }
+
+        if (type != NULL
+            && (resect_mapped_type_get_kind(mapped, mapped_type) != resect_type_get_kind(type)
+                || strcmp(resect_mapped_type_get_name(mapped, mapped_type), resect_type_get_name(type)) != 0
+                || resect_mapped_type_sizeof(mapped, mapped_type) != resect_type_sizeof(type)
+                || resect_mapped_type_alignof(mapped, mapped_type) != resect_type_alignof(type))) {
+            printf("MAPPED TYPE MISMATCH: %s\n", id);
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+int is_same_type(resect_type this, resect_type that) {
+    if (this == NULL || that == NULL) {
+        return this == that;
+    }
+    return resect_type_get_kind(this) == resect_type_get_kind(that)
+           && strcmp(resect_type_get_name(this), resect_type_get_name(that)) == 0
+           && resect_type_sizeof(this) == resect_type_sizeof(that)
+           && resect_type_alignof(this) == resect_type_alignof(that);
+}
+
+int compare_loaded_decls(resect_translation_unit unit, resect_translation_unit loaded) {
+    int mismatches = 0;
+    resect_collection decls = resect_unit_declarations(unit);
+    if (resect_collection_size(decls) != resect_collection_size(resect_unit_declarations(loaded))) {
+        printf("LOADED MISMATCH: declaration count\n");
+        ++mismatches;
+    }
+
+    resect_iterator decl_iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(decl_iter)) {
+        resect_decl decl = resect_iterator_value(decl_iter);
+        resect_decl loaded_decl = resect_unit_find_decl_by_id(loaded, resect_decl_get_id(decl));
+        if (loaded_decl == NULL
+            || resect_decl_get_kind(loaded_decl) != resect_decl_get_kind(decl)
+            || strcmp(resect_decl_get_name(loaded_decl), resect_decl_get_name(decl)) != 0
+            || strcmp(resect_decl_get_namespace(loaded_decl), resect_decl_get_namespace(decl)) != 0
+            || !is_same_type(resect_decl_get_type(loaded_decl), resect_decl_get_type(decl))) {
+            printf("LOADED MISMATCH: %s\n", resect_decl_get_id(decl));
+            ++mismatches;
+        }
+    }
+    resect_iterator_free(decl_iter);
+    return mismatches;
+}
+
+int check_round_trip(resect_translation_unit unit, const char *path) {
+    if (!resect_unit_save(unit, path)) {
+        printf("ROUND TRIP: failed to save %s\n", path);
+        return 1;
+    }
+
+    int mismatches = 0;
+    resect_translation_unit loaded = resect_unit_load(path);
+    if (loaded != NULL) {
+        mismatches += compare_loaded_decls(unit, loaded);
+        resect_free(loaded);
+    } else {
+        printf("ROUND TRIP: failed to load %s\n", path);
+        ++mismatches;
+    }
+
+    resect_mapped_unit mapped = resect_unit_map(path);
+    if (mapped != NULL) {
+        mismatches += compare_mapped_decls(unit, mapped);
+        resect_unit_unmap(mapped);
+    } else {
+        printf("ROUND TRIP: failed to map %s\n", path);
+        ++mismatches;
+    }
+
+    remove(path);
+    printf("ROUND TRIP: %d mismatches\n", mismatches);
+    return mismatches;
+}
+
+typedef struct {
+    resect_translation_unit unit;
+    void **visited;
+    unsigned int visited_count;
+    unsigned int visited_capacity;
+    resect_type *declared_types;
+    unsigned int declared_type_count;
+    unsigned int declared_type_capacity;
+    const char *label;
+    int mismatches;
+} canonical_check;
+
+int canonical_check_visit(canonical_check *check, void *value) {
+    if (value == NULL) {
+        return 0;
+    }
+    for (unsigned int i = 0; i < check->visited_count; ++i) {
+        if (check->visited[i] == value) {
+            return 0;
+        }
+    }
+    if (check->visited_count == check->visited_capacity) {
+        check->visited_capacity = check->visited_capacity == 0 ? 256 : check->visited_capacity * 2;
+        check->visited = realloc(check->visited, check->visited_capacity * sizeof(void *));
+    }
+    check->visited[check->visited_count++] = value;
+    return 1;
+}
+
+void check_canonical_decl(canonical_check *check, resect_decl decl);
 
+void check_canonical_type(canonical_check *check, resect_type type);
+
+void check_canonical_decls(canonical_check *check, resect_collection decls) {
+    resect_iterator iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(iter)) {
+        check_canonical_decl(check, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+}
+
+void check_canonical_types(canonical_check *check, resect_collection types) {
+    resect_iterator iter = resect_collection_iterator(types);
+    while (resect_iterator_next(iter)) {
+        check_canonical_type(check, resect_iterator_value(iter));
+    }
+    resect_iterator_free(iter);
+}
+
+void check_canonical_template_arguments(canonical_check *check, resect_collection arguments) {
+    resect_iterator iter = resect_collection_iterator(arguments);
+    while (resect_iterator_next(iter)) {
+        check_canonical_type(check, resect_template_argument_get_type(resect_iterator_value(iter)));
+    }
+    resect_iterator_free(iter);
+}
+
+void check_canonical_declared_type(canonical_check *check, resect_type type, resect_decl decl) {
+    for (unsigned int i = 0; i < check->declared_type_count; ++i) {
+        resect_type other = check->declared_types[i];
+        if (strcmp(resect_decl_get_id(resect_type_get_declaration(other)), resect_decl_get_id(decl)) == 0
+            && strcmp(resect_type_get_name(other), resect_type_get_name(type)) == 0) {
+            printf("%s MISMATCH: type %s of %s is not unique\n", check->label, resect_type_get_name(type),
+                   resect_decl_get_id(decl));
+            ++check->mismatches;
+            return;
+        }
+    }
+    if (check->declared_type_count == check->declared_type_capacity) {
+        check->declared_type_capacity = check->declared_type_capacity == 0 ? 64 : check->declared_type_capacity * 2;
+        check->declared_types = realloc(check->declared_types, check->declared_type_capacity * sizeof(resect_type));
+    }
+    check->declared_types[check->declared_type_count++] = type;
+}
+
+void check_canonical_type(canonical_check *check, resect_type type) {
+    if (!canonical_check_visit(check, type)) {
+        return;
+    }
+
+    resect_decl decl = resect_type_get_declaration(type);
+    if (decl != NULL) {
+        check_canonical_declared_type(check, type, decl);
+        check_canonical_decl(check, decl);
+    }
+
+    resect_iterator field_iter = resect_collection_iterator(resect_type_fields(type));
+    while (resect_iterator_next(field_iter)) {
+        check_canonical_type(check, resect_type_field_get_type(resect_iterator_value(field_iter)));
+    }
+    resect_iterator_free(field_iter);
+
+    resect_iterator method_iter = resect_collection_iterator(resect_type_methods(type));
+    while (resect_iterator_next(method_iter)) {
+        check_canonical_decl(check, resect_type_method_get_decl(resect_iterator_value(method_iter)));
+    }
+    resect_iterator_free(method_iter);
+
+    check_canonical_types(check, resect_type_base_classes(type));
+    check_canonical_template_arguments(check, resect_type_template_arguments(type));
+
+    switch (resect_type_get_category(type)) {
+        case RESECT_TYPE_CATEGORY_POINTER:
+            check_canonical_type(check, resect_pointer_get_pointee_type(type));
+            break;
+        case RESECT_TYPE_CATEGORY_REFERENCE:
+            check_canonical_type(check, resect_reference_get_pointee_type(type));
+            break;
+        case RESECT_TYPE_CATEGORY_ARRAY:
+            check_canonical_type(check, resect_array_get_element_type(type));
+            break;
+        default:
+            if (resect_type_get_kind(type) == RESECT_TYPE_KIND_FUNCTIONPROTO) {
+                check_canonical_type(check, resect_function_proto_get_result_type(type));
+                check_canonical_types(check, resect_function_proto_parameters(type));
+            }
+    }
+}
+
+void check_canonical_decl(canonical_check *check, resect_decl decl) {
+    if (!canonical_check_visit(check, decl)) {
+        return;
+    }
+
+    if (resect_unit_find_decl_by_id(check->unit, resect_decl_get_id(decl)) != decl) {
+        printf("%s MISMATCH: decl %s is not unique\n", check->label, resect_decl_get_id(decl));
+        ++check->mismatches;
+    }
+
+    check_canonical_type(check, resect_decl_get_type(decl));
+    check_canonical_decl(check, resect_decl_get_owner(decl));
+    check_canonical_decl(check, resect_decl_get_template(decl));
+    check_canonical_decls(check, resect_decl_template_parameters(decl));
+    check_canonical_template_arguments(check, resect_decl_template_arguments(decl));
+    check_canonical_decls(check, resect_decl_template_specializations(decl));
+
+    switch (resect_decl_get_kind(decl)) {
+        case RESECT_DECL_KIND_STRUCT:
+        case RESECT_DECL_KIND_UNION:
+        case RESECT_DECL_KIND_CLASS:
+            check_canonical_decls(check, resect_record_fields(decl));
+            check_canonical_decls(check, resect_record_methods(decl));
+            check_canonical_types(check, resect_record_parents(decl));
+            break;
+        case RESECT_DECL_KIND_FUNCTION:
+            check_canonical_decls(check, resect_function_parameters(decl));
+            break;
+        case RESECT_DECL_KIND_METHOD:
+            check_canonical_decls(check, resect_method_parameters(decl));
+            break;
+        case RESECT_DECL_KIND_ENUM:
+            check_canonical_decls(check, resect_enum_constants(decl));
+            break;
+        case RESECT_DECL_KIND_TYPEDEF:
+            check_canonical_type(check, resect_typedef_get_aliased_type(decl));
+            break;
+        default:;
+    }
+}
+
+/*
+ * every decl reachable from the unit must be the one registered under its id and every declared type must be
+ * the only one with its name and declaration
+ */
+int check_canonical_pointers(resect_translation_unit unit, const char *label) {
+    canonical_check check = {.unit = unit, .label = label};
+
+    check_canonical_decls(&check, resect_unit_declarations(unit));
+
+    free(check.visited);
+    free(check.declared_types);
+
+    printf("%s: %d canonical mismatches\n", label, check.mismatches);
+    return check.mismatches;
+}
+
+int check_parallel_parse(resect_translation_unit unit, const char *filename, resect_parse_options options) {
+    resect_options_parallel(options, 4);
+    resect_translation_unit parallel = resect_parse(filename, options);
+    if (parallel == NULL) {
+        printf("PARALLEL: failed to parse %s\n", filename);
+        return 1;
+    }
+
+    int mismatches = 0;
+    resect_collection decls = resect_unit_declarations(unit);
+    if (resect_collection_size(decls) != resect_collection_size(resect_unit_declarations(parallel))) {
+        printf("PARALLEL MISMATCH: declaration count\n");
+        ++mismatches;
+    }
+
+    resect_iterator decl_iter = resect_collection_iterator(decls);
+    while (resect_iterator_next(decl_iter)) {
+        resect_decl decl = resect_iterator_value(decl_iter);
+        resect_decl parallel_decl = resect_unit_find_decl_by_id(parallel, resect_decl_get_id(decl));
+        if (parallel_decl == NULL
+            || resect_decl_get_kind(parallel_decl) != resect_decl_get_kind(decl)
+            || strcmp(resect_decl_get_name(parallel_decl), resect_decl_get_name(decl)) != 0
+            || strcmp(resect_decl_get_namespace(parallel_decl), resect_decl_get_namespace(decl)) != 0
+            || !is_same_type(resect_decl_get_type(parallel_decl), resect_decl_get_type(decl))) {
+            printf("PARALLEL MISMATCH: %s\n", resect_decl_get_id(decl));
+            ++mismatches;
+        }
+    }
+    resect_iterator_free(decl_iter);
+
+    mismatches += check_canonical_pointers(parallel, "PARALLEL");
+
+    resect_free(parallel);
+
+    printf("PARALLEL: %d mismatches\n", mismatches);
+    return mismatches;
+}
+
+char *read_file(const char *filename, long *length) {
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *contents = malloc(*length + 1);
+    *length = (long) fread(contents, 1, *length, file);
+    contents[*length] = '\0';
+    fclose(file);
+    return contents;
+}
+
+/*
+ * reparse without changes must keep every decl as is, reparse with changes must pick them up
+ */
+int check_reparse(const char *filename, resect_parse_options options) {
+    resect_options_reparseable(options);
+    resect_translation_unit unit = resect_parse(filename, options);
+    if (unit == NULL) {
+        printf("REPARSE: failed to parse %s\n", filename);
+        return 1;
+    }
+
+    resect_collection decls = resect_unit_declarations(unit);
+    unsigned int decl_count = resect_collection_size(decls);
+    resect_decl *parsed_decls = malloc((decl_count + 1) * sizeof(resect_decl));
+    resect_iterator decl_iter = resect_collection_iterator(decls);
+    for (unsigned int i = 0; resect_iterator_next(decl_iter); ++i) {
+        parsed_decls[i] = resect_iterator_value(decl_iter);
+    }
+    resect_iterator_free(decl_iter);
+
+    int mismatches = 0;
+    if (!resect_reparse(unit, NULL)) {
+        printf("REPARSE: failed to reparse %s\n", filename);
+        ++mismatches;
+    } else {
+        for (unsigned int i = 0; i < decl_count; ++i) {
+            if (resect_unit_find_decl_by_id(unit, resect_decl_get_id(parsed_decls[i])) != parsed_decls[i]) {
+                printf("REPARSE MISMATCH: %s\n", resect_decl_get_id(parsed_decls[i]));
+                ++mismatches;
+            }
+        }
+        if (resect_collection_size(resect_unit_declarations(unit)) != decl_count) {
+            printf("REPARSE MISMATCH: declaration count\n");
+            ++mismatches;
+        }
+    }
+
+    long length = 0;
+    char *contents = read_file(filename, &length);
+    if (contents != NULL) {
+        const char *probe = "\nnamespace Testo { struct ReparseProbe { int value; }; }\n";
+        char *changed_contents = malloc(length + strlen(probe) + 1);
+        memcpy(changed_contents, contents, length);
+        strcpy(changed_contents + length, probe);
+
+        resect_unsaved_files unsaved_files = resect_unsaved_files_create();
+        resect_unsaved_files_add(unsaved_files, filename, changed_contents, strlen(changed_contents));
+        if (!resect_reparse(unit, unsaved_files)
+            || resect_unit_find_decl_by_name(unit, "Testo::ReparseProbe") == NULL) {
+            printf("REPARSE MISMATCH: change not picked up\n");
+            ++mismatches;
+        } else {
+            mismatches += check_canonical_pointers(unit, "REPARSE");
+        }
+        resect_unsaved_files_free(unsaved_files);
+        free(changed_contents);
+        free(contents);
+    }
+
+    free(parsed_decls);
+    resect_free(unit);
+
+    printf("REPARSE: %d mismatches\n", mismatches);
+    return mismatches;
+}
+
+resect_parse_options create_options() {
     resect_parse_options options = resect_options_create();
     resect_options_include_definition(options, "Testo::.*");
     resect_options_exclude_definition(options, "std::.*");
@@ -127,10 +556,16 @@ int main(int argc, char **argv) {
 
     resect_options_add_target(options, "x86_64-pc-linux-gnu");
     resect_options_print_diagnostics(options);
+    resect_options_evaluate_macros(options);
+    return options;
+}
 
-    resect_translation_unit context = resect_parse(filename, options);
+int main(int argc, char **argv) {
+    char *filename = argc > 1 ? argv[1] : "../test/Testo.hpp";
 
-    resect_options_free(options);
+    resect_parse_options options = create_options();
+
+    resect_translation_unit context = resect_parse(filename, options);
 
     printf("LANGUAGE: %d\n", resect_unit_get_language(context));
 
@@ -170,6 +605,7 @@ int main(int argc, char **argv) {
                 if (resect_type_is_const_qualified(resect_decl_get_type(decl))) {
                     printf("   CONST\n");
                 }
+                print_variable_value(decl);
                 break;
             case RESECT_DECL_KIND_TYPEDEF:
                 printf(" TYPEDEF: %s::%s (%d) {%lld}\n", resect_decl_get_namespace(decl), resect_decl_get_name(decl),
@@ -187,6 +623,7 @@ int main(int argc, char **argv) {
                 break;
             case RESECT_DECL_KIND_MACRO:
                 printf(" MACRO: %s\n", resect_decl_get_name(decl));
+                print_macro_value(decl);
                 break;
             default:;
         }
@@ -196,7 +633,14 @@ int main(int argc, char **argv) {
     }
     resect_iterator_free(decl_iter);
 
+    int mismatches = check_canonical_pointers(context, "SEQUENTIAL");
+    mismatches += check_round_trip(context, "resect-test.unit");
+    mismatches += check_parallel_parse(context, filename, options);
+    mismatches += check_reparse(filename, options);
+
+    resect_options_free(options);
+
     resect_free(context);
 
-    return 0;
+    return mismatches == 0 ? 0 : 1;
 }